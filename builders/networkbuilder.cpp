@@ -6,8 +6,10 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "networkbuilder.h"
+#include "misc/memoryReport.h"
 #include "misc/tools.h"
 #include "misc/userInput.h"
+#include "network/networkstate.h"
 #include "numscalNetworkBuilder.h"
 #include "operations/pnmOperation.h"
 #include "regularNetworkBuilder.h"
@@ -51,10 +53,26 @@ std::shared_ptr<networkModel> networkBuilder::getNetwork() const {
   return network;
 }
 
-void networkBuilder::initialise() { tools::createRequiredFolders(); }
+std::shared_ptr<networkState> networkBuilder::getInitialState() const {
+  return initialState;
+}
+
+void networkBuilder::initialise() {
+  tools::createRequiredFolders();
+
+  auto size = estimateNetworkSize();
+  std::cout << "Estimated memory requirement (MB): "
+            << memoryReport::estimateNetworkUsage(size.first, size.second) /
+                   (1024. * 1024.)
+            << std::endl;
+}
 
 void networkBuilder::finalise() {
+  pnmOperation::get(network).reorderNetwork();
   pnmOperation::get(network).exportToNumcalFormat();
+  initialState = networkState::capture(network);
+  memoryReport::get().updateNetworkUsage(network);
+  memoryReport::get().printReport();
   emit finished();
 }
 
@@ -10,12 +10,14 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
 #include <QObject>
 
 namespace PNM {
 
 class networkModel;
+class networkState;
 
 class networkBuilder : public QObject {
   Q_OBJECT
@@ -25,6 +27,7 @@ class networkBuilder : public QObject {
   virtual std::string getNotification() = 0;
   virtual int getProgress();
   std::shared_ptr<networkModel> getNetwork() const;
+  std::shared_ptr<networkState> getInitialState() const;
 
  signals:
   void notifyGUI();
@@ -37,11 +40,13 @@ class networkBuilder : public QObject {
   auto operator=(const networkBuilder &) -> networkBuilder & = delete;
   auto operator=(networkBuilder &&) -> networkBuilder & = delete;
   virtual void make() = 0;
+  virtual std::pair<long long, long long> estimateNetworkSize() = 0;
   void initialise();
   void finalise();
   void signalProgress(int);
 
   std::shared_ptr<networkModel> network;
+  std::shared_ptr<networkState> initialState;
   int progress;
 };
 
@@ -13,10 +13,12 @@
 #include "network/networkmodel.h"
 
 #include <QDir>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 
 namespace PNM {
@@ -54,6 +56,21 @@ void numscalNetworkBuilder::initiateNetworkProperties() {
   network->maxConnectionNumber = 0;
 }
 
+std::pair<long long, long long> numscalNetworkBuilder::estimateNetworkSize() {
+  std::string prefix = userInput::get().extractedNetworkFolderPath +
+                       userInput::get().rockPrefix;
+
+  // One line per element after the column header
+  auto countRows = [](std::string filePath) -> long long {
+    std::ifstream file(filePath.c_str());
+    long long rows = std::count(std::istreambuf_iterator<char>(file),
+                                std::istreambuf_iterator<char>(), '\n');
+    return std::max(rows - 1, 0LL);
+  };
+
+  return {countRows(prefix + "_nodes.num"), countRows(prefix + "_throats.num")};
+}
+
 void numscalNetworkBuilder::importNodes() {
   std::string filePath = userInput::get().extractedNetworkFolderPath +
                          userInput::get().rockPrefix + "_nodes.num";
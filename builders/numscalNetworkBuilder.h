@@ -26,6 +26,7 @@ class numscalNetworkBuilder : public regularNetworkBuilder {
 
  protected:
   void initiateNetworkProperties() override;
+  std::pair<long long, long long> estimateNetworkSize() override;
   void importNodes();
   void importPores();
   void assignMissingValues();
@@ -83,6 +83,15 @@ void regularNetworkBuilder::initiateNetworkProperties() {
   network->is2D = Nz == 1 ? true : false;
 }
 
+std::pair<long long, long long> regularNetworkBuilder::estimateNetworkSize() {
+  long long Nx = userInput::get().Nx;
+  long long Ny = userInput::get().Ny;
+  long long Nz = userInput::get().Nz;
+
+  return {Nx * Ny * Nz, (Nx + 1) * Ny * Nz + Nx * (Ny + 1) * Nz +
+                            Nx * Ny * (Nz + 1)};
+}
+
 void regularNetworkBuilder::createNodes() {
   std::cout << "Creating Nodes..." << std::endl;
 
@@ -322,7 +331,6 @@ void regularNetworkBuilder::assignWettabilities() {
   std::cout << "Setting wettabilities..." << std::endl;
 
   pnmOperation::get(network).assignWettabilities();
-  pnmOperation::get(network).backupWettability();
 
   signalProgress(80);
 }
@@ -331,6 +339,7 @@ void regularNetworkBuilder::calculateProperties() {
   std::cout << "Calculating network properties..." << std::endl;
 
   pnmOperation::get(network).calculateNetworkVolume();
+  pnmOperation::get(network).assignConductivityFactors();
   pnmSolver::get(network).calculatePermeabilityAndPorosity();
 
   signalProgress(100);
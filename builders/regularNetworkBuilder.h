@@ -29,6 +29,7 @@ class regularNetworkBuilder : public networkBuilder {
 
  protected:
   virtual void initiateNetworkProperties();
+  std::pair<long long, long long> estimateNetworkSize() override;
   void createNodes();
   void createPores();
   void assignNeighboors();
@@ -53,6 +53,21 @@ void statoilNetworkBuilder::initiateNetworkProperties() {
   network->is2D = false;
 }
 
+std::pair<long long, long long> statoilNetworkBuilder::estimateNetworkSize() {
+  // Both counts are the first entry of the Statoil headers
+  std::string prefix = userInput::get().extractedNetworkFolderPath +
+                       userInput::get().rockPrefix;
+  long long totalNodes(0), totalPores(0);
+
+  std::ifstream nodeFile((prefix + "_node1.dat").c_str());
+  nodeFile >> totalNodes;
+
+  std::ifstream linkFile((prefix + "_link1.dat").c_str());
+  linkFile >> totalPores;
+
+  return {totalNodes, totalPores};
+}
+
 void statoilNetworkBuilder::importNode1() {
   std::string filePath = userInput::get().extractedNetworkFolderPath +
                          userInput::get().rockPrefix + "_node1.dat";
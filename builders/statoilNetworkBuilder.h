@@ -26,6 +26,7 @@ class statoilNetworkBuilder : public regularNetworkBuilder {
 
  protected:
   void initiateNetworkProperties() override;
+  std::pair<long long, long long> estimateNetworkSize() override;
   void importNode1();
   void importNode2();
   void importLink1();
@@ -87,8 +87,9 @@ void MainWindow::on_twoPhaseSimButton_clicked() {
     try {
       sim = PNM::simulation::createSimulation();
       sim->setNetwork(network);
+      sim->setInitialState(builder->getInitialState());
       connect(sim.get(), SIGNAL(notifyGUI()), this,
-              SLOT(updateGUIDuringSimulation()), Qt::BlockingQueuedConnection);
+              SLOT(updateGUIDuringSimulation()), Qt::QueuedConnection);
       connect(sim.get(), SIGNAL(finished()), this,
               SLOT(updateGUIAfterSimulation()));
       sim->execute();
@@ -352,8 +353,12 @@ void MainWindow::updateGUIAfterSimulation() {
 }
 
 void MainWindow::updateGUIDuringSimulation() {
-  ui->simulationProgressBar->setValue(sim->getProgress());
-  ui->SimNotif->setText(QString::fromStdString(sim->getNotification()));
+  auto snapshot = sim->getSnapshot();
+  if (!snapshot) return;
+
+  ui->simulationProgressBar->setValue(snapshot->progress);
+  ui->SimNotif->setText(QString::fromStdString(snapshot->notification));
+  ui->widget->setSnapshot(snapshot);
 }
 
 void MainWindow::updateGUIBeforeRendering() {
@@ -384,6 +389,7 @@ void MainWindow::updateGUIDuringRendering() {
   ui->renderingProgressBar->setValue(sim->getProgress());
   ui->SimNotif->setText(QString::fromStdString(sim->getNotification()));
 
+  ui->widget->requestRefresh();
   exportNetworkToImage();
 }
 
@@ -15,6 +15,7 @@
 #include "misc/tools.h"
 #include "misc/userInput.h"
 #include "network/iterator.h"
+#include "simulations/simulation.h"
 
 #include <QApplication>
 #include <QMouseEvent>
@@ -134,6 +135,17 @@ void widget3d::initialiseDataBuffers() {
   lineIndicesBuffer.clear();
   lineIndicesBuffer.resize(2 * lineCount);
 
+  // host copies; the GPU holds the same amount again
+  PNM::memoryReport::get().record(
+      "Render buffers",
+      (staticSphereBuffer.capacity() + dynamicSphereBuffer.capacity() +
+       staticCylinderBuffer.capacity() + dynamicCylinderBuffer.capacity() +
+       staticLineBuffer.capacity() + dynamicLineBuffer.capacity()) *
+              sizeof(GLfloat) +
+          (sphereIndicesBuffer.capacity() + cylinderIndicesBuffer.capacity() +
+           lineIndicesBuffer.capacity()) *
+              sizeof(GLint));
+
   // initialise buffers
 
   bufferSphereStaticData();
@@ -176,11 +188,11 @@ void widget3d::bufferSphereDynamicData() {
 
   for (node *p : pnmRange<node>(network)) {
     // color data
+    phase phaseFlag = getDisplayedPhase(p);
     float colorKey =
-        p->getPhaseFlag() == phase::oil || p->getPhaseFlag() == phase::temp ? 0
-                                                                            : 1;
+        phaseFlag == phase::oil || phaseFlag == phase::temp ? 0 : 1;
     dynamicSphereBuffer[indexDynamic] = colorKey;
-    dynamicSphereBuffer[indexDynamic + 1] = float(p->getConcentration());
+    dynamicSphereBuffer[indexDynamic + 1] = getDisplayedConcentration(p);
 
     // update indices
     indexDynamic += 2;
@@ -194,13 +206,14 @@ void widget3d::bufferSphereIndicesData() {
   unsigned index(0);
 
   for (node *p : pnmRange<node>(network)) {
-    if ((p->getPhaseFlag() == phase::invalid) ||
-        (p->getPhaseFlag() == phase::oil && !oilVisible) ||
-        (p->getPhaseFlag() == phase::temp && !oilVisible) ||
-        (p->getPhaseFlag() == phase::water && !waterVisible) ||
-        (p->getWettabilityFlag() == wettability::waterWet &&
-         !waterWetVisible) ||
-        (p->getWettabilityFlag() == wettability::oilWet && !oilWetVisible) ||
+    phase phaseFlag = getDisplayedPhase(p);
+    wettability wettabilityFlag = getDisplayedWettability(p);
+    if ((phaseFlag == phase::invalid) ||
+        (phaseFlag == phase::oil && !oilVisible) ||
+        (phaseFlag == phase::temp && !oilVisible) ||
+        (phaseFlag == phase::water && !waterVisible) ||
+        (wettabilityFlag == wettability::waterWet && !waterWetVisible) ||
+        (wettabilityFlag == wettability::oilWet && !oilWetVisible) ||
         (cutX && p->getXCoordinate() > cutXValue * network->xEdgeLength) ||
         (cutY && p->getYCoordinate() > cutYValue * network->yEdgeLength) ||
         (cutZ && p->getZCoordinate() > cutZValue * network->zEdgeLength))
@@ -273,11 +286,11 @@ void widget3d::bufferCylinderDynamicData() {
     }
 
     // color data
+    phase phaseFlag = getDisplayedPhase(p);
     float colorKey =
-        p->getPhaseFlag() == phase::oil || p->getPhaseFlag() == phase::temp ? 0
-                                                                            : 1;
+        phaseFlag == phase::oil || phaseFlag == phase::temp ? 0 : 1;
     dynamicCylinderBuffer[indexDynamic] = colorKey;
-    dynamicCylinderBuffer[indexDynamic + 1] = p->getConcentration();
+    dynamicCylinderBuffer[indexDynamic + 1] = getDisplayedConcentration(p);
 
     indexDynamic += 2;
   }
@@ -290,14 +303,15 @@ void widget3d::bufferCylinderIndicesData() {
   unsigned index(0);
 
   for (pore *p : pnmRange<pore>(network)) {
+    phase phaseFlag = getDisplayedPhase(p);
+    wettability wettabilityFlag = getDisplayedWettability(p);
     if ((p->getInlet() || p->getOutlet()) ||
-        (p->getPhaseFlag() == phase::invalid) ||
-        (p->getPhaseFlag() == phase::oil && !oilVisible) ||
-        (p->getPhaseFlag() == phase::temp && !oilVisible) ||
-        (p->getPhaseFlag() == phase::water && !waterVisible) ||
-        (p->getWettabilityFlag() == wettability::waterWet &&
-         !waterWetVisible) ||
-        (p->getWettabilityFlag() == wettability::oilWet && !oilWetVisible) ||
+        (phaseFlag == phase::invalid) ||
+        (phaseFlag == phase::oil && !oilVisible) ||
+        (phaseFlag == phase::temp && !oilVisible) ||
+        (phaseFlag == phase::water && !waterVisible) ||
+        (wettabilityFlag == wettability::waterWet && !waterWetVisible) ||
+        (wettabilityFlag == wettability::oilWet && !oilWetVisible) ||
         (cutX &&
          p->getNodeIn()->getXCoordinate() > cutXValue * network->xEdgeLength) ||
         (cutY &&
@@ -359,17 +373,17 @@ void widget3d::bufferLineDynamicData() {
     }
 
     // color data
+    phase phaseFlag = getDisplayedPhase(p);
     float colorKey =
-        p->getPhaseFlag() == phase::oil || p->getPhaseFlag() == phase::temp ? 0
-                                                                            : 1;
+        phaseFlag == phase::oil || phaseFlag == phase::temp ? 0 : 1;
 
     // node1
     dynamicLineBuffer[indexDynamic] = colorKey;
-    dynamicLineBuffer[indexDynamic + 1] = p->getConcentration();
+    dynamicLineBuffer[indexDynamic + 1] = getDisplayedConcentration(p);
 
     // node2
     dynamicLineBuffer[indexDynamic + 2] = colorKey;
-    dynamicLineBuffer[indexDynamic + 3] = p->getConcentration();
+    dynamicLineBuffer[indexDynamic + 3] = getDisplayedConcentration(p);
 
     indexDynamic += 4;
   }
@@ -383,14 +397,15 @@ void widget3d::bufferLinesIndicesData() {
   unsigned index(0);
 
   for (pore *p : pnmRange<pore>(network)) {
+    phase phaseFlag = getDisplayedPhase(p);
+    wettability wettabilityFlag = getDisplayedWettability(p);
     if ((p->getInlet() || p->getOutlet()) ||
-        (p->getPhaseFlag() == phase::invalid) ||
-        (p->getPhaseFlag() == phase::oil && !oilVisible) ||
-        (p->getPhaseFlag() == phase::temp && !oilVisible) ||
-        (p->getPhaseFlag() == phase::water && !waterVisible) ||
-        (p->getWettabilityFlag() == wettability::waterWet &&
-         !waterWetVisible) ||
-        (p->getWettabilityFlag() == wettability::oilWet && !oilWetVisible) ||
+        (phaseFlag == phase::invalid) ||
+        (phaseFlag == phase::oil && !oilVisible) ||
+        (phaseFlag == phase::temp && !oilVisible) ||
+        (phaseFlag == phase::water && !waterVisible) ||
+        (wettabilityFlag == wettability::waterWet && !waterWetVisible) ||
+        (wettabilityFlag == wettability::oilWet && !oilWetVisible) ||
         (cutX && p->getXCoordinate() > cutXValue * network->xEdgeLength) ||
         (cutY && p->getYCoordinate() > cutYValue * network->yEdgeLength) ||
         (cutZ && p->getZCoordinate() > cutZValue * network->zEdgeLength))
@@ -529,7 +544,7 @@ void widget3d::loadShaderUniformsAxes(Shader *shader) {
 void widget3d::drawSpheres() {
   sphereShader->use();
   loadShaderUniforms(sphereShader.get());
-  if (simulationRunnning || refreshRequested) {
+  if (refreshRequested) {
     bufferSphereDynamicData();
     bufferSphereIndicesData();
   }
@@ -541,7 +556,7 @@ void widget3d::drawSpheres() {
 void widget3d::drawCylinders() {
   cylinderShader->use();
   loadShaderUniforms(cylinderShader.get());
-  if (simulationRunnning || refreshRequested) {
+  if (refreshRequested) {
     bufferCylinderDynamicData();
     bufferCylinderIndicesData();
   }
@@ -553,7 +568,7 @@ void widget3d::drawCylinders() {
 void widget3d::drawLines() {
   lineShader->use();
   loadShaderUniforms(lineShader.get());
-  if (simulationRunnning || refreshRequested) {
+  if (refreshRequested) {
     bufferLineDynamicData();
     bufferLinesIndicesData();
   }
@@ -753,7 +768,43 @@ void widget3d::setNetworkBuilt(bool value) {
   }
 }
 
-void widget3d::setSimulationRunnning(bool value) { simulationRunnning = value; }
+void widget3d::setSimulationRunnning(bool value) {
+  simulationRunnning = value;
+  snapshot.reset();
+  refreshRequested = true;
+}
+
+// While a simulation runs, the dynamic data are only rebuffered when a new
+// snapshot arrives, and they are read from the snapshot rather than from the
+// network that the simulation thread keeps updating.
+void widget3d::setSnapshot(
+    const std::shared_ptr<const PNM::simulationSnapshot> &value) {
+  if (!simulationRunnning) return;
+  snapshot = value;
+  refreshRequested = true;
+}
+
+void widget3d::requestRefresh() { refreshRequested = true; }
+
+int widget3d::snapshotIndex(element *e) const {
+  return e->getType() == capillaryType::throat
+             ? network->totalNodes + e->getId() - 1
+             : e->getId() - 1;
+}
+
+phase widget3d::getDisplayedPhase(element *e) const {
+  return snapshot ? snapshot->phases[snapshotIndex(e)] : e->getPhaseFlag();
+}
+
+wettability widget3d::getDisplayedWettability(element *e) const {
+  return snapshot ? snapshot->wettabilities[snapshotIndex(e)]
+                  : e->getWettabilityFlag();
+}
+
+float widget3d::getDisplayedConcentration(element *e) const {
+  return snapshot ? snapshot->concentrations[snapshotIndex(e)]
+                  : float(e->getConcentration());
+}
 
 glm::vec3 &widget3d::getOilColor() { return oilColor; }
 
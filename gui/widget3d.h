@@ -14,7 +14,11 @@
 
 namespace PNM {
 class networkModel;
-}
+class element;
+struct simulationSnapshot;
+enum class phase;
+enum class wettability;
+}  // namespace PNM
 
 class Shader;
 class QMouseEvent;
@@ -126,6 +130,8 @@ class widget3d : public QOpenGLWidget {
   void setTracerColor(const glm::vec3 &value);
 
   void setSimulationRunnning(bool value);
+  void setSnapshot(const std::shared_ptr<const PNM::simulationSnapshot> &value);
+  void requestRefresh();
 
  public slots:
   void timerUpdate();
@@ -145,6 +151,11 @@ class widget3d : public QOpenGLWidget {
   void bufferSphereDynamicData();
   void bufferSphereIndicesData();
 
+  PNM::phase getDisplayedPhase(PNM::element *e) const;
+  PNM::wettability getDisplayedWettability(PNM::element *e) const;
+  float getDisplayedConcentration(PNM::element *e) const;
+  int snapshotIndex(PNM::element *e) const;
+
   void bufferAxesData();
   void loadShaderUniforms(Shader *shader);
   void loadShaderUniformsAxes(Shader *shader);
@@ -184,6 +195,8 @@ class widget3d : public QOpenGLWidget {
   std::shared_ptr<Shader> sphereShader, cylinderShader, lineShader;
   // network model
   std::shared_ptr<PNM::networkModel> network;
+  // latest state handed over by a running simulation
+  std::shared_ptr<const PNM::simulationSnapshot> snapshot;
   // timer
   std::shared_ptr<QTimer> timer;
 };
@@ -6,9 +6,55 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <QApplication>
+#include "builders/networkbuilder.h"
 #include "gui/mainwindow.h"
+#include "misc/tools.h"
+#include "misc/userInput.h"
+#include "network/networkmodel.h"
+#include "simulations/simulation.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// numSCAL --headless: builds the network and runs the simulation set in
+// Input_Data/Parameters.txt without the GUI. The absolute permeability and
+// porosity of the network are written to Results/networkProperties.txt.
+int runHeadless() {
+  try {
+    PNM::userInput::get().loadNetworkData();
+    auto builder = PNM::networkBuilder::createBuilder();
+    auto network = builder->build();
+
+    std::ofstream file(tools::outputPath("Results/networkProperties.txt"));
+    file.precision(std::numeric_limits<double>::max_digits10);
+    file << "Perm.(mD)\tPorosity(%)\n"
+         << network->absolutePermeability / 0.987e-15 << "\t"
+         << network->porosity * 100 << std::endl;
+
+    PNM::userInput::get().loadSimulationData();
+    auto sim = PNM::simulation::createSimulation();
+    sim->setNetwork(network);
+    sim->setInitialState(builder->getInitialState());
+    sim->execute();
+  } catch (std::exception &ex) {
+    std::cout << "A problem has occured.\n" << ex.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
 
 int main(int argc, char *argv[]) {
+  if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+    QCoreApplication a(argc, argv);
+    return runHeadless();
+  }
+
   QApplication a(argc, argv);
 
   MainWindow window;
@@ -0,0 +1,244 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "checkpoint.h"
+#include "misc/tools.h"
+#include "misc/userInput.h"
+#include "network/iterator.h"
+#include "network/networkstate.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace PNM {
+
+namespace {
+const char checkpointMagic[8] = {'n', 'u', 'm', 'S', 'C', 'A', 'L', 'c'};
+const int32_t version = 3;
+
+struct checkpointHeader {
+  char magic[8];
+  int32_t version;
+  int32_t seed;
+  int64_t totalNodes;
+  int64_t totalPores;
+  checkpointVariables variables;
+  int64_t resultFiles;
+};
+
+template <typename T>
+void writeValue(std::ostream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void readValue(std::istream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+struct checkpointContents {
+  checkpointVariables variables;
+  std::vector<std::pair<std::string, long long>> fileSizes;
+  std::string simulationData;
+  std::shared_ptr<networkState> state;
+};
+
+// Reads and validates a checkpoint file without applying it
+bool readCheckpoint(const std::string &path,
+                    std::shared_ptr<networkModel> network,
+                    checkpointContents &contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+
+  checkpointHeader header;
+  readValue(file, header);
+  if (!file || std::memcmp(header.magic, checkpointMagic, 8) != 0 ||
+      header.version != version) {
+    std::cout << "ERROR: " << path << " is not a valid checkpoint" << std::endl;
+    return false;
+  }
+  if (header.totalNodes != network->totalNodes ||
+      header.totalPores != network->totalPores) {
+    std::cout << "ERROR: " << path << " was saved on a different network"
+              << std::endl;
+    return false;
+  }
+  if (header.seed != userInput::get().seed)
+    std::cout << "WARNING: " << path << " was saved with seed " << header.seed
+              << std::endl;
+
+  contents.fileSizes.clear();
+  for (int64_t i = 0; i < header.resultFiles; ++i) {
+    int64_t length(0), size(0);
+    readValue(file, length);
+    if (length < 0 || length > 4096) file.setstate(std::ios::failbit);
+    if (!file) break;
+    std::string resultFile(length, ' ');
+    file.read(&resultFile[0], length);
+    readValue(file, size);
+    contents.fileSizes.emplace_back(resultFile, size);
+  }
+
+  int64_t dataSize(0);
+  readValue(file, dataSize);
+  if (dataSize < 0 || dataSize > (int64_t(1) << 40))
+    file.setstate(std::ios::failbit);
+  if (file) {
+    contents.simulationData.assign(dataSize, '\0');
+    file.read(&contents.simulationData[0], dataSize);
+  }
+  if (!file) {
+    std::cout << "ERROR: " << path << ": truncated checkpoint" << std::endl;
+    return false;
+  }
+
+  try {
+    contents.state = networkState::read(network, file);
+  } catch (const std::runtime_error &e) {
+    std::cout << "ERROR: " << path << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  contents.variables = header.variables;
+  return true;
+}
+}  // namespace
+
+checkpoint::checkpoint(const std::string &simulationName)
+    : path(tools::outputPath("Checkpoints/" + simulationName + ".chk")),
+      lastSave(std::chrono::steady_clock::now()) {}
+
+checkpoint::~checkpoint() { waitForWriter(); }
+
+bool checkpoint::isDue() const {
+  double interval = userInput::get().checkpointInterval;
+  if (interval <= 0) return false;
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - lastSave;
+  return elapsed.count() >= interval;
+}
+
+void checkpoint::save(std::shared_ptr<networkModel> network,
+                      const checkpointVariables &variables,
+                      const std::vector<std::string> &resultFiles,
+                      const std::string &simulationData) {
+  // Only the in-memory capture runs on the simulation thread, which also
+  // reads the parameters of the run (userInput::get() is per thread)
+  waitForWriter();
+
+  auto state = networkState::capture(network);
+  std::vector<std::pair<std::string, long long>> fileSizes;
+  for (const std::string &file : resultFiles)
+    fileSizes.emplace_back(file, tools::fileSize(file));
+
+  int seed = userInput::get().seed;
+  if (userInput::get().checkpointInBackground)
+    writer = std::thread(&checkpoint::write, this, state, variables, seed,
+                         std::move(fileSizes), simulationData);
+  else
+    write(state, variables, seed, std::move(fileSizes), simulationData);
+
+  lastSave = std::chrono::steady_clock::now();
+}
+
+void checkpoint::write(
+    std::shared_ptr<networkState> state, checkpointVariables variables,
+    int seed, std::vector<std::pair<std::string, long long>> fileSizes,
+    std::string simulationData) const {
+  auto network = state->getNetwork();
+  std::string tempPath = path + ".tmp";
+
+  std::vector<char> buffer(1 << 20);
+  std::ofstream file;
+  file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  file.open(tempPath, std::ios::binary | std::ios::trunc);
+
+  checkpointHeader header;
+  std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+  header.version = version;
+  header.seed = seed;
+  header.totalNodes = network->totalNodes;
+  header.totalPores = network->totalPores;
+  header.variables = variables;
+  header.resultFiles = fileSizes.size();
+  writeValue(file, header);
+
+  for (const auto &fileSize : fileSizes) {
+    writeValue(file, int64_t(fileSize.first.size()));
+    file.write(fileSize.first.data(), fileSize.first.size());
+    writeValue(file, int64_t(fileSize.second));
+  }
+
+  writeValue(file, int64_t(simulationData.size()));
+  file.write(simulationData.data(), simulationData.size());
+
+  state->write(file);
+  file.close();
+
+  if (!file) {
+    std::cout << "ERROR: Checkpoint " << path << " could not be written"
+              << std::endl;
+    return;
+  }
+
+  // Replace the previous checkpoint only once the new one is complete. POSIX
+  // rename replaces it atomically; where rename cannot replace an existing
+  // file, the previous checkpoint is kept as .bak so that one always exists.
+#ifdef _WIN32
+  std::string backupPath = path + ".bak";
+  std::remove(backupPath.c_str());
+  std::rename(path.c_str(), backupPath.c_str());
+#endif
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    std::cout << "ERROR: Checkpoint " << path << " could not be replaced"
+              << std::endl;
+}
+
+bool checkpoint::restore(std::shared_ptr<networkModel> network,
+                         checkpointVariables &variables,
+                         std::string *simulationData) {
+  waitForWriter();
+
+  // A run stopped while a checkpoint was being replaced can leave the file
+  // missing or incomplete: the new (.tmp) then the previous (.bak) one are
+  // tried next
+  checkpointContents contents;
+  std::string restoredPath;
+  for (const std::string &candidate : {path, path + ".tmp", path + ".bak"})
+    if (readCheckpoint(candidate, network, contents)) {
+      restoredPath = candidate;
+      break;
+    }
+
+  if (restoredPath.empty()) {
+    std::cout << "No checkpoint found in " << path
+              << ", starting a new simulation" << std::endl;
+    return false;
+  }
+
+  contents.state->restore();
+  variables = contents.variables;
+  if (simulationData) *simulationData = contents.simulationData;
+
+  // Drop the results written after the checkpoint was taken
+  for (const auto &fileSize : contents.fileSizes)
+    tools::truncateFile(fileSize.first, fileSize.second);
+
+  std::cout << "Simulation restarted from " << restoredPath << std::endl;
+  lastSave = std::chrono::steady_clock::now();
+  return true;
+}
+
+void checkpoint::waitForWriter() {
+  if (writer.joinable()) writer.join();
+}
+
+}  // namespace PNM
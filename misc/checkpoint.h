@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "misc/outputSchedule.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PNM {
+
+class networkModel;
+class networkState;
+
+// Scalar state of a transient simulation, saved next to the network state
+struct checkpointVariables {
+  double timeSoFar = 0;
+  double injectedPVs = 0;
+  outputScheduleState curvesOutput;
+  outputScheduleState networkStatesOutput;
+  double currentSw = 0;
+  int frameCount = 0;
+  int fillingEventsBatch = 0;
+};
+
+// Binary restart file of a transient simulation (Checkpoints/<name>.chk).
+// A checkpoint holds the network state, the simulation variables, the size of
+// the result files at the time it was taken, so that a restarted run drops the
+// lines written after the checkpoint and continues from there, and any state
+// specific to the simulation, stored as given (simulationData).
+// The network state is captured in memory by save() and written to disk in a
+// background thread (one pending write at most) unless disabled.
+class checkpoint {
+ public:
+  explicit checkpoint(const std::string &simulationName);
+  ~checkpoint();
+  checkpoint(const checkpoint &) = delete;
+  checkpoint(checkpoint &&) = delete;
+  auto operator=(const checkpoint &) -> checkpoint & = delete;
+  auto operator=(checkpoint &&) -> checkpoint & = delete;
+  bool isDue() const;
+  void save(std::shared_ptr<networkModel>, const checkpointVariables &,
+            const std::vector<std::string> &resultFiles = {},
+            const std::string &simulationData = std::string());
+  bool restore(std::shared_ptr<networkModel>, checkpointVariables &,
+               std::string *simulationData = nullptr);
+
+ protected:
+  void write(std::shared_ptr<networkState>, checkpointVariables, int seed,
+             std::vector<std::pair<std::string, long long>>,
+             std::string simulationData) const;
+  void waitForWriter();
+
+  std::string path;
+  std::thread writer;
+  std::chrono::steady_clock::time_point lastSave;
+};
+
+}  // namespace PNM
+
+#endif  // CHECKPOINT_H
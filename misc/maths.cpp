@@ -15,4 +15,43 @@ double PsiToPa(const double &pressure) { return pressure / 14.50377 * 1e5; }
 
 double PaToPsi(const double &pressure) { return pressure * 14.50377 / 1e5; }
 
+// Space-filling curve keys over 21-bit integer coordinates (63-bit keys)
+
+unsigned long long mortonKey(unsigned x, unsigned y, unsigned z) {
+  unsigned long long key(0);
+  for (int bit = 20; bit >= 0; --bit) {
+    key = (key << 1) | ((x >> bit) & 1);
+    key = (key << 1) | ((y >> bit) & 1);
+    key = (key << 1) | ((z >> bit) & 1);
+  }
+  return key;
+}
+
+unsigned long long hilbertKey(unsigned x, unsigned y, unsigned z) {
+  // Skilling's transform from axes to the transposed Hilbert index
+  unsigned X[3] = {x, y, z};
+  const unsigned M = 1u << 20;
+
+  for (unsigned Q = M; Q > 1; Q >>= 1) {
+    unsigned P = Q - 1;
+    for (int i = 0; i < 3; ++i) {
+      if (X[i] & Q)
+        X[0] ^= P;
+      else {
+        unsigned t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  for (int i = 1; i < 3; ++i) X[i] ^= X[i - 1];
+  unsigned t(0);
+  for (unsigned Q = M; Q > 1; Q >>= 1)
+    if (X[2] & Q) t ^= Q - 1;
+  for (int i = 0; i < 3; ++i) X[i] ^= t;
+
+  return mortonKey(X[0], X[1], X[2]);
+}
+
 }  // namespace maths
@@ -12,5 +12,7 @@ namespace maths {
 double pi();
 double PsiToPa(double const &pressure);
 double PaToPsi(double const &pressure);
+unsigned long long mortonKey(unsigned x, unsigned y, unsigned z);
+unsigned long long hilbertKey(unsigned x, unsigned y, unsigned z);
 }  // namespace maths
 #endif  // MATHS_H
@@ -0,0 +1,120 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "memoryReport.h"
+#include "misc/tools.h"
+#include "network/cluster.h"
+#include "network/iterator.h"
+#include "operations/hkClustering.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace PNM {
+
+namespace {
+// Heap bookkeeping of a shared_ptr control block (counters and deleter)
+const std::size_t controlBlockSize = 2 * sizeof(long) + 2 * sizeof(void *);
+
+double toMB(std::size_t bytes) { return bytes / (1024. * 1024.); }
+}  // namespace
+
+memoryReport memoryReport::instance;
+thread_local memoryReport *memoryReport::active = nullptr;
+
+memoryReport &memoryReport::get() { return active ? *active : instance; }
+
+void memoryReport::record(const std::string &subsystem, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(usageMutex);
+  usage[subsystem] = bytes;
+}
+
+void memoryReport::updateNetworkUsage(std::shared_ptr<networkModel> network) {
+  std::size_t elements(0), neighboors(0), clusters(0);
+
+  elements += network->tableOfNodes.capacity() * sizeof(networkModel::nodePtr);
+  elements += network->tableOfPores.capacity() * sizeof(networkModel::porePtr);
+  elements += network->tableOfNodes.size() * (sizeof(node) + controlBlockSize);
+  elements += network->tableOfPores.size() * (sizeof(pore) + controlBlockSize);
+  elements += (network->inletPores.capacity() +
+               network->outletPores.capacity()) *
+              sizeof(pore *);
+  elements += (network->nodeSourceIds.capacity() +
+               network->poreSourceIds.capacity()) *
+              sizeof(int);
+
+  const coldAttributes &cold = element::cold();
+  elements += cold.films.blocks.capacity() * sizeof(filmAttributes);
+  elements += cold.tracers.blocks.capacity() * sizeof(tracerAttributes);
+  elements += (cold.films.released.capacity() +
+               cold.tracers.released.capacity()) *
+              sizeof(int);
+
+  for (element *e : pnmRange<element>(network))
+    neighboors += e->getNeighboors().capacity() * sizeof(element *);
+
+  hkClustering &clustering = hkClustering::get(network);
+  for (auto *clusterList :
+       {&clustering.waterClusters, &clustering.oilClusters,
+        &clustering.waterWetClusters, &clustering.oilWetClusters,
+        &clustering.oilFilmClusters, &clustering.waterFilmClusters,
+        &clustering.oilLayerClusters, &clustering.waterLayerClusters,
+        &clustering.activeClusters}) {
+    clusters += clusterList->capacity() * sizeof(clusterPtr);
+    clusters += clusterList->size() * (sizeof(cluster) + controlBlockSize);
+  }
+
+  record("Elements", elements);
+  record("Neighbour lists", neighboors);
+  record("Clusters", clusters);
+}
+
+void memoryReport::printReport() {
+  std::lock_guard<std::mutex> lock(usageMutex);
+
+  std::size_t total(0);
+  for (auto it : usage) total += it.second;
+
+  std::ofstream file(tools::outputPath("Results/Profiling/memoryUsage.txt"));
+  file << "Subsystem\tMemory (MB)" << std::endl;
+
+  // Formatted apart so that std::cout keeps its own flags
+  std::ostringstream console;
+  console << "Memory usage (MB):\n" << std::left << std::fixed
+          << std::setprecision(2);
+
+  for (auto it : usage) {
+    file << it.first << "\t" << toMB(it.second) << std::endl;
+    console << "  " << std::setw(24) << it.first << toMB(it.second) << "\n";
+  }
+
+  file << "Total\t" << toMB(total) << std::endl;
+  console << "  " << std::setw(24) << "Total" << toMB(total) << "\n";
+  std::cout << console.str() << std::flush;
+}
+
+std::size_t memoryReport::estimateNetworkUsage(long long totalNodes,
+                                               long long totalPores) {
+  // Every pore links two nodes: two neighbour entries per pore on each side
+  std::size_t perNode = sizeof(node) + controlBlockSize +
+                        sizeof(networkModel::nodePtr) +
+                        sizeof(std::vector<element *>);
+  std::size_t perPore = sizeof(pore) + controlBlockSize +
+                        sizeof(networkModel::porePtr) + 4 * sizeof(element *);
+
+  // Pressure matrix: one diagonal and two off-diagonal entries per pore,
+  // stored with their row indices
+  std::size_t perMatrixEntry = sizeof(double) + sizeof(int);
+  std::size_t matrix =
+      (totalNodes + 2 * totalPores) * perMatrixEntry + totalNodes * sizeof(int);
+
+  return totalNodes * perNode + totalPores * perPore + matrix;
+}
+
+}  // namespace PNM
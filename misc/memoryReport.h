@@ -0,0 +1,66 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace PNM {
+
+class networkModel;
+
+// Bytes held by the main subsystems. The network related entries are
+// computed on demand; the solver and the renderer record their own usage
+// whenever they (re)allocate.
+class memoryReport {
+ public:
+  class scope;
+
+  static memoryReport &get();
+  void record(const std::string &subsystem, std::size_t bytes);
+  void updateNetworkUsage(std::shared_ptr<networkModel>);
+  void printReport();
+  static std::size_t estimateNetworkUsage(long long totalNodes,
+                                          long long totalPores);
+
+ protected:
+  memoryReport() {}
+  memoryReport(const memoryReport &) = delete;
+  memoryReport(memoryReport &&) = delete;
+  auto operator=(const memoryReport &) -> memoryReport & = delete;
+  auto operator=(memoryReport &&) -> memoryReport & = delete;
+
+  std::map<std::string, std::size_t> usage;
+  std::mutex usageMutex;
+  static memoryReport instance;
+  static thread_local memoryReport *active;
+};
+
+// Per-thread report while in scope, so that each batch scenario reports its
+// own usage (see userInput::scope)
+class memoryReport::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  memoryReport own;
+  memoryReport *previous;
+};
+
+}  // namespace PNM
+
+#endif  // MEMORYREPORT_H
@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "outputSchedule.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PNM {
+
+namespace {
+const double firstLogSpacedStep = 1e-3;
+}
+
+void outputSchedule::initialise(const outputSettings &value) {
+  settings = value;
+  state = outputScheduleState();
+  state.step = firstLogSpacedStep;
+  events = 0;
+  lastOutputTime = std::chrono::steady_clock::now();
+}
+
+bool outputSchedule::isDue(double progress) {
+  ++events;
+
+  bool due(false);
+  switch (settings.policy) {
+    case outputPolicy::progress:
+      due = std::abs(progress - state.lastOutput) >= settings.interval;
+      break;
+    case outputPolicy::events:
+      due = events >= settings.interval;
+      break;
+    case outputPolicy::wallTime: {
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - lastOutputTime;
+      due = elapsed.count() >= settings.interval;
+      break;
+    }
+    case outputPolicy::logSpaced:
+      due = std::abs(progress - state.lastOutput) >= state.step;
+      if (due) state.step *= std::pow(10, 1 / std::max(settings.interval, 1.));
+      break;
+  }
+
+  if (!due) return false;
+
+  state.lastOutput = progress;
+  events = 0;
+  lastOutputTime = std::chrono::steady_clock::now();
+  return true;
+}
+
+}  // namespace PNM
@@ -0,0 +1,49 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef OUTPUTSCHEDULE_H
+#define OUTPUTSCHEDULE_H
+
+#include "misc/userInput.h"
+
+#include <chrono>
+
+namespace PNM {
+
+// Position of an output schedule, saved in checkpoints
+struct outputScheduleState {
+  double lastOutput = 0;  // progress at the last output
+  double step = 0;        // current spacing of log-spaced outputs
+};
+
+// Decides when an output stream (results curves, relative permeabilities,
+// network state files) is written. The progress variable is the number of
+// injected PVs in transient simulations and Sw in quasi-static ones.
+// Policies (see outputPolicy):
+//  - progress: every `interval` of progress (0.01 by default)
+//  - events: every `interval` calls to isDue (time steps or invasion rounds)
+//  - wallTime: every `interval` seconds
+//  - logSpaced: `interval` outputs per decade, the spacing between outputs
+//    growing geometrically from 1e-3
+class outputSchedule {
+ public:
+  void initialise(const outputSettings &);
+  // A true return is taken as the output being written at this progress
+  bool isDue(double progress);
+  outputScheduleState getState() const { return state; }
+  void setState(const outputScheduleState &value) { state = value; }
+
+ protected:
+  outputSettings settings;
+  outputScheduleState state;
+  long long events = 0;
+  std::chrono::steady_clock::time_point lastOutputTime;
+};
+
+}  // namespace PNM
+
+#endif  // OUTPUTSCHEDULE_H
@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "parallel.h"
+#include "misc/userInput.h"
+
+namespace parallel {
+
+unsigned threadCount() {
+  int threads = PNM::userInput::get().threads;
+  if (threads > 0) return threads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+workerPool::~workerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  started.notify_all();
+  for (std::thread &worker : workers) worker.join();
+}
+
+void workerPool::run(int tasks, const std::function<void(int)> &f) {
+  std::lock_guard<std::mutex> batchLock(batchMutex);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (static_cast<int>(workers.size()) < tasks - 1)
+      workers.emplace_back(&workerPool::work, this);
+
+    task = &f;
+    config = &PNM::userInput::get();
+    states = PNM::element::getActiveStates();
+    errors.assign(tasks, nullptr);
+    totalTasks = tasks;
+    nextTask = 0;
+    pendingTasks = tasks;
+    ++batch;
+  }
+  started.notify_all();
+
+  executeTasks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [this]() { return pendingTasks == 0; });
+  totalTasks = 0;
+  task = nullptr;
+
+  for (std::exception_ptr &error : errors)
+    if (error) std::rethrow_exception(error);
+}
+
+void workerPool::work() {
+  unsigned seenBatch = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    started.wait(lock, [&]() { return stopping || batch != seenBatch; });
+    if (stopping) return;
+    seenBatch = batch;
+
+    lock.unlock();
+    executeTasks();
+    lock.lock();
+  }
+}
+
+// Takes the tasks of the current batch until none is left
+void workerPool::executeTasks() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (nextTask < totalTasks) {
+    int i = nextTask++;
+    lock.unlock();
+
+    {
+      PNM::userInput::scope scope(*config);
+      PNM::elementStates *previousStates =
+          PNM::element::activateStates(states);
+      try {
+        (*task)(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+      PNM::element::activateStates(previousStates);
+    }
+
+    lock.lock();
+    if (--pendingTasks == 0) finished.notify_all();
+  }
+}
+
+workerPool &pool() {
+  workerPool *scoped = PNM::userInput::scope::getWorkerPool();
+  if (scoped) return *scoped;
+
+  static workerPool shared;
+  return shared;
+}
+
+}  // namespace parallel
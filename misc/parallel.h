@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "misc/userInput.h"
+#include "network/element.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Worker threads used by the loops below (FluidInjection_Misc.threads,
+// all the cores when set to 0)
+unsigned threadCount();
+
+// Persistent worker threads of the loops below. Every userInput::scope owns
+// its own pool and the threads outside any scope share one; the batches of a
+// pool run one at a time. Workers are started when a batch needs more of
+// them than the pool has, and stopped with the pool.
+class workerPool {
+ public:
+  workerPool() {}
+  ~workerPool();
+  workerPool(const workerPool &) = delete;
+  workerPool(workerPool &&) = delete;
+  auto operator=(const workerPool &) -> workerPool & = delete;
+  auto operator=(workerPool &&) -> workerPool & = delete;
+
+  // Calls task(i) for every i in [0, tasks) on the calling thread and the
+  // workers, which see the userInput and element states of the calling
+  // thread. Once all tasks are done, the exception of the first failed task,
+  // if any, is rethrown on the calling thread.
+  void run(int tasks, const std::function<void(int)> &task);
+
+ private:
+  void work();
+  void executeTasks();
+
+  std::mutex batchMutex;
+  std::mutex mutex;
+  std::condition_variable started;
+  std::condition_variable finished;
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors;
+  const std::function<void(int)> *task = nullptr;
+  PNM::userInput *config = nullptr;
+  PNM::elementStates *states = nullptr;
+  int totalTasks = 0;
+  int nextTask = 0;
+  int pendingTasks = 0;
+  unsigned batch = 0;
+  bool stopping = false;
+};
+
+// Pool of the calling thread (see workerPool)
+workerPool &pool();
+
+// Ranges shorter than this are not worth a thread
+const int minChunkSize = 4096;
+
+inline int chunkCount(int size) {
+  return std::max(1, std::min<int>(threadCount(), size / minChunkSize));
+}
+
+// Splits [0, size) into chunkCount(size) contiguous chunks and calls
+// f(begin, end, chunk) for each of them on the pool of the calling thread.
+// Reductions are done by writing one partial result per chunk and combining
+// them in chunk order, which keeps results independent of the scheduling.
+template <typename F>
+void forChunks(int size, F f) {
+  int chunks = chunkCount(size);
+  if (chunks == 1) {
+    if (size > 0) f(0, size, 0);
+    return;
+  }
+
+  auto chunkBegin = [size, chunks](int chunk) {
+    return static_cast<int>(static_cast<long long>(size) * chunk / chunks);
+  };
+
+  pool().run(chunks, [&f, chunkBegin](int chunk) {
+    f(chunkBegin(chunk), chunkBegin(chunk + 1), chunk);
+  });
+}
+
+}  // namespace parallel
+
+#endif  // PARALLEL_H
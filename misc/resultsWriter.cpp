@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "resultsWriter.h"
+#include "misc/userInput.h"
+
+#include <cstdint>
+
+namespace PNM {
+
+namespace {
+const std::size_t maxBufferedRecords = 4096;
+
+void writeUInt32(std::ofstream &file, uint32_t value) {
+  file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+}  // namespace
+
+void resultsWriter::open(const std::string &basePath,
+                         const std::vector<std::string> &columns,
+                         bool append) {
+  close();
+
+  binary = userInput::get().binaryResults;
+  path = basePath + (binary ? ".bin" : ".txt");
+  bufferedRecords = 0;
+  textBuffer.str("");
+  columnBuffers.assign(columns.size(), {});
+  lastFlush = std::chrono::steady_clock::now();
+
+  auto mode = binary ? std::ios::binary : std::ios::openmode();
+  file.open(path, mode | (append ? std::ios::app : std::ios::trunc));
+  if (append) return;
+
+  if (binary) {
+    file.write("numSCALr", 8);
+    writeUInt32(file, columns.size());
+    for (const std::string &column : columns) {
+      writeUInt32(file, column.size());
+      file.write(column.data(), column.size());
+    }
+  } else {
+    for (std::size_t i = 0; i < columns.size(); ++i)
+      file << columns[i] << (i + 1 < columns.size() ? "\t" : "\n");
+  }
+  file.flush();
+}
+
+void resultsWriter::write(std::initializer_list<double> values) {
+  if (binary) {
+    auto column = columnBuffers.begin();
+    for (double value : values) (column++)->push_back(value);
+  } else {
+    std::size_t i = 0;
+    for (double value : values)
+      textBuffer << value << (++i < values.size() ? "\t" : "\n");
+  }
+  ++bufferedRecords;
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - lastFlush;
+  if (bufferedRecords >= maxBufferedRecords ||
+      elapsed.count() >= userInput::get().resultsFlushInterval)
+    flush();
+}
+
+void resultsWriter::flush() {
+  lastFlush = std::chrono::steady_clock::now();
+  if (!file.is_open() || bufferedRecords == 0) return;
+
+  if (binary) {
+    writeUInt32(file, bufferedRecords);
+    for (std::vector<double> &column : columnBuffers) {
+      file.write(reinterpret_cast<const char *>(column.data()),
+                 column.size() * sizeof(double));
+      column.clear();
+    }
+  } else {
+    file << textBuffer.str();
+    textBuffer.str("");
+  }
+
+  bufferedRecords = 0;
+  file.flush();
+}
+
+void resultsWriter::close() {
+  if (!file.is_open()) return;
+  flush();
+  file.close();
+}
+
+}  // namespace PNM
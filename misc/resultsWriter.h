@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RESULTSWRITER_H
+#define RESULTSWRITER_H
+
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace PNM {
+
+// Time series results file kept open for the whole simulation. Records are
+// buffered in memory and written out when the buffer is full, when the
+// flush interval (FluidInjection_USS.resultsFlushInterval seconds) has
+// elapsed, on flush() and when the writer is closed.
+//
+// Text files (<path>.txt) hold a tab separated header line followed by one
+// line per record. Binary files (<path>.bin, FluidInjection_USS.binaryResults)
+// are columnar:
+//   "numSCALr" | uint32 columns | columns x (uint32 length, name)
+// followed by blocks of records:
+//   uint32 records | columns x (records x double)
+class resultsWriter {
+ public:
+  resultsWriter() {}
+  ~resultsWriter() { close(); }
+  resultsWriter(const resultsWriter &) = delete;
+  resultsWriter(resultsWriter &&) = delete;
+  auto operator=(const resultsWriter &) -> resultsWriter & = delete;
+  auto operator=(resultsWriter &&) -> resultsWriter & = delete;
+
+  void open(const std::string &path, const std::vector<std::string> &columns,
+            bool append = false);
+  void write(std::initializer_list<double> values);
+  void flush();
+  void close();
+  const std::string &getPath() const { return path; }
+
+ protected:
+  std::string path;
+  std::ofstream file;
+  bool binary = false;
+  std::size_t bufferedRecords = 0;
+  std::ostringstream textBuffer;
+  std::vector<std::vector<double>> columnBuffers;
+  std::chrono::steady_clock::time_point lastFlush;
+};
+
+}  // namespace PNM
+
+#endif  // RESULTSWRITER_H
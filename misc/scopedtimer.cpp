@@ -7,4 +7,6 @@
 
 #include "scopedtimer.h"
 
-std::unordered_map<const char *, std::pair<double, int>> ScopedTimer::profile;
+ScopedTimer::ProfileData ScopedTimer::profile;
+thread_local ScopedTimer::ProfileData *ScopedTimer::active = nullptr;
+std::mutex ScopedTimer::profileMutex;
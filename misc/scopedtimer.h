@@ -8,9 +8,12 @@
 #ifndef SCOPEDTIMER_H
 #define SCOPEDTIMER_H
 
+#include "misc/tools.h"
+
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <unordered_map>
 
 #define MEASURE_FUNCTION() \
@@ -19,6 +22,9 @@
 class ScopedTimer {
  public:
   using ClockType = std::chrono::steady_clock;
+  using ProfileData = std::unordered_map<const char *, std::pair<double, int>>;
+
+  class scope;
 
   ScopedTimer(const char *func) : function_{func}, start_{ClockType::now()} {}
 
@@ -32,14 +38,18 @@ class ScopedTimer {
     auto stop = ClockType::now();
     auto duration = (stop - start_);
     auto ns = duration_cast<nanoseconds>(duration).count();
-    profile[function_].first += ns;
-    profile[function_].second++;
+    std::lock_guard<std::mutex> lock(profileMutex);
+    ProfileData &data = active ? *active : profile;
+    data[function_].first += ns;
+    data[function_].second++;
   }
 
   static void printProfileData() {
-    std::ofstream profileData("Results/Profiling/profileData.txt");
+    std::lock_guard<std::mutex> lock(profileMutex);
+    std::ofstream profileData(
+        tools::outputPath("Results/Profiling/profileData.txt"));
     profileData << "Function\tCalls\tT (ms)\tAvg. T per Call (ms)" << std::endl;
-    for (auto it : ScopedTimer::profile) {
+    for (auto it : active ? *active : profile) {
       profileData << it.first;
       profileData << "\t" << it.second.second;
       profileData << "\t" << it.second.first / 1e6;
@@ -49,9 +59,27 @@ class ScopedTimer {
   }
 
  private:
-  static std::unordered_map<const char *, std::pair<double, int>> profile;
+  static ProfileData profile;
+  static thread_local ProfileData *active;
+  static std::mutex profileMutex;  // concurrent batch scenarios
   const char *function_ = {};
   const ClockType::time_point start_ = {};
 };
 
+// Per-thread profile while in scope, so that each batch scenario reports its
+// own timings (see userInput::scope)
+class ScopedTimer::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  ProfileData own;
+  ProfileData *previous;
+};
+
 #endif  // SCOPEDTIMER_H
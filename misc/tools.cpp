@@ -6,19 +6,27 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "tools.h"
+#include "userInput.h"
 
 #include <QDir>
+#include <QFile>
 
 #include <cstdlib>
 
 namespace tools {
 
+// Output folders of the current run (see userInput::outputDirectory)
+std::string outputPath(const std::string &path) {
+  return PNM::userInput::get().outputDirectory + path;
+}
+
 void createRequiredFolders() {
   createFolder("Input_Data");
-  createFolder("Results");
-  createFolder("Results/Profiling");
+  createFolder(outputPath("Results"));
+  createFolder(outputPath("Results/Profiling"));
   createFolder("Videos");
-  createFolder("Network_State");
+  createFolder(outputPath("Network_State"));
+  createFolder(outputPath("Checkpoints"));
   createFolder("numSCAL_Networks");
 }
 
@@ -27,7 +35,7 @@ void initialiseFolder(std::string path) {
   cleanFolder(path);
 }
 
-void createFolder(std::string path) { QDir().mkdir(path.c_str()); }
+void createFolder(std::string path) { QDir().mkpath(path.c_str()); }
 
 void cleanFolder(std::string path) {
   QDir directory(path.c_str());
@@ -35,6 +43,12 @@ void cleanFolder(std::string path) {
   for (QString filename : files) directory.remove(filename);
 }
 
+long long fileSize(std::string path) { return QFile(path.c_str()).size(); }
+
+void truncateFile(std::string path, long long size) {
+  QFile(path.c_str()).resize(size);
+}
+
 void cleanVideosFolder() {
   QDir directory("Videos");
   QStringList pngFiles =
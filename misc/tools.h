@@ -11,10 +11,13 @@
 #include <string>
 
 namespace tools {
+std::string outputPath(const std::string &);
 void createRequiredFolders();
 void initialiseFolder(std::string);
 void createFolder(std::string);
 void cleanFolder(std::string);
+long long fileSize(std::string);
+void truncateFile(std::string, long long);
 void cleanVideosFolder();
 void renderVideo(int fps = 25);
 }  // namespace tools
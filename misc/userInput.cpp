@@ -7,6 +7,7 @@
 
 #include "userInput.h"
 #include "maths.h"
+#include "parallel.h"
 
 #include <libs/boost/property_tree/ini_parser.hpp>
 #include <libs/boost/property_tree/ptree.hpp>
@@ -16,8 +17,29 @@ namespace PNM {
 userInput::userInput() {}
 
 userInput userInput::instance;
+thread_local userInput *userInput::active = nullptr;
 
-userInput &userInput::get() { return instance; }
+userInput &userInput::get() { return active ? *active : instance; }
+
+thread_local userInput::scope *userInput::scope::activeScope = nullptr;
+
+userInput::scope::scope(userInput &config)
+    : previous(active), previousScope(activeScope) {
+  active = &config;
+  activeScope = this;
+}
+
+userInput::scope::~scope() {
+  active = previous;
+  activeScope = previousScope;
+}
+
+parallel::workerPool *userInput::scope::getWorkerPool() {
+  if (!activeScope) return nullptr;
+  if (!activeScope->workers)
+    activeScope->workers.reset(new parallel::workerPool);
+  return activeScope->workers.get();
+}
 
 void userInput::loadNetworkData() {
   boost::property_tree::ptree pt;
@@ -29,6 +51,8 @@ void userInput::loadNetworkData() {
   extractedNetworkFolderPath =
       pt.get<std::string>("NetworkGeneration_Source.extractedNetworkPath");
   rockPrefix = pt.get<std::string>("NetworkGeneration_Source.rockPrefix");
+  networkOrdering = (nodeOrdering)pt.get<int>(
+      "NetworkGeneration_Source.networkOrdering", 0);
 
   Nx = pt.get<int>("NetworkGeneration_Geometry.Nx");
   Ny = pt.get<int>("NetworkGeneration_Geometry.Ny");
@@ -88,6 +112,7 @@ void userInput::loadSimulationData() {
   drainageUSS = pt.get<bool>("FluidInjection_Cycles.drainageUSS");
   tracerFlow = pt.get<bool>("FluidInjection_Cycles.tracerFlow");
   templateFlow = pt.get<bool>("FluidInjection_Cycles.templateFlow");
+  scenarioBatch = pt.get<bool>("FluidInjection_Cycles.scenarioBatch", false);
   primaryDrainageSimulation =
       pt.get<bool>("FluidInjection_Cycles.primaryDrainageSimulation");
   spontaneousImbibitionSimulation =
@@ -101,10 +126,16 @@ void userInput::loadSimulationData() {
 
   twoPhaseSimulationSteps =
       pt.get<int>("FluidInjection_SS.twoPhaseSimulationSteps");
+  pcSteppingMode =
+      (pcStepping)pt.get<int>("FluidInjection_SS.pcSteppingMode", 0);
+  maxSwChangePerStep =
+      pt.get<double>("FluidInjection_SS.maxSwChangePerStep", 0.02);
   filmConductanceResistivity =
       pt.get<double>("FluidInjection_SS.filmConductanceResistivity");
   relativePermeabilitiesCalculation =
       pt.get<bool>("FluidInjection_SS.relativePermeabilitiesCalculation");
+  relativePermeabilityWorkers =
+      pt.get<int>("FluidInjection_SS.relativePermeabilityWorkers", 2);
   extractDataSS = pt.get<bool>("FluidInjection_SS.extractDataSS");
 
   flowRate = pt.get<double>("FluidInjection_USS.flowRate");
@@ -115,6 +146,32 @@ void userInput::loadSimulationData() {
   tracerDiffusionCoef =
       pt.get<double>("FluidInjection_USS.tracerDiffusionCoef");
   extractDataUSS = pt.get<bool>("FluidInjection_USS.extractDataUSS");
+  eventDrivenUSS = pt.get<bool>("FluidInjection_USS.eventDriven", false);
+  maxFillingEventsPerSolve =
+      pt.get<int>("FluidInjection_USS.maxFillingEventsPerSolve", 1);
+  flowChangeTolerance =
+      pt.get<double>("FluidInjection_USS.flowChangeTolerance", 0.05);
+  activeSetSolver = pt.get<bool>("FluidInjection_USS.activeSetSolver", false);
+  checkpointInterval =
+      pt.get<double>("FluidInjection_USS.checkpointInterval", 0);
+  checkpointInBackground =
+      pt.get<bool>("FluidInjection_USS.checkpointInBackground", true);
+  restartFromCheckpoint =
+      pt.get<bool>("FluidInjection_USS.restartFromCheckpoint", false);
+  binaryResults = pt.get<bool>("FluidInjection_USS.binaryResults", false);
+  resultsFlushInterval =
+      pt.get<double>("FluidInjection_USS.resultsFlushInterval", 5);
+
+  auto loadOutputSettings = [&pt](const std::string &stream) {
+    outputSettings settings;
+    settings.policy =
+        (outputPolicy)pt.get<int>("Output." + stream + "Policy", 0);
+    settings.interval = pt.get<double>("Output." + stream + "Interval", 0.01);
+    return settings;
+  };
+  curvesOutput = loadOutputSettings("curves");
+  relativePermeabilitiesOutput = loadOutputSettings("relativePermeabilities");
+  networkStatesOutput = loadOutputSettings("networkStates");
 
   oilViscosity = pt.get<double>("FluidInjection_Fluids.oilViscosity") * 1e-3;
   waterViscosity =
@@ -132,6 +189,9 @@ void userInput::loadSimulationData() {
       (swi)pt.get<int>("FluidInjection_Fluids.waterDistribution");
 
   solverChoice = (solver)pt.get<int>("FluidInjection_Misc.solverChoice");
+  threads = pt.get<int>("FluidInjection_Misc.threads", 0);
+  guiUpdateInterval =
+      pt.get<double>("FluidInjection_Misc.guiUpdateInterval", 0.1);
 
   pathToNetworkStateFiles = pt.get<std::string>(
       "FluidInjection_Postprocessing.pathToNetworkStateFiles");
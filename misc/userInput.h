@@ -8,8 +8,13 @@
 #ifndef USERINPUT_H
 #define USERINPUT_H
 
+#include <memory>
 #include <string>
 
+namespace parallel {
+class workerPool;
+}
+
 namespace PNM {
 
 enum class networkWettability {
@@ -36,8 +41,34 @@ enum class swi {
 
 enum class solver { cholesky = 1, conjugateGradient = 2 };
 
+enum class nodeOrdering {
+  none = 0,
+  reverseCuthillMcKee = 1,
+  hilbert = 2,
+  morton = 3
+};
+
+enum class pcStepping { linear = 0, logSpaced = 1, adaptive = 2 };
+
+enum class outputPolicy {
+  progress = 0,
+  events = 1,
+  wallTime = 2,
+  logSpaced = 3
+};
+
+struct outputSettings {
+  outputPolicy policy = outputPolicy::progress;
+  double interval = 0.01;
+};
+
+// Parameters of the current run. get() returns the shared instance, unless
+// the calling thread opened a scope on its own copy (batch scenarios run
+// concurrently with different parameters).
 class userInput {
  public:
+  class scope;
+
   static userInput &get();
   void loadNetworkData();
   void loadSimulationData();
@@ -69,7 +100,10 @@ class userInput {
   int Nz;
   psd poreSizeDistribution;
   solver solverChoice;
+  int threads;
+  double guiUpdateInterval;
   networkWettability wettability;
+  nodeOrdering networkOrdering;
   bool networkRegular;
   bool networkStatoil;
   bool networkNumscal;
@@ -83,6 +117,7 @@ class userInput {
   bool drainageUSS;
   bool tracerFlow;
   bool templateFlow;
+  bool scenarioBatch;
 
   // SS
   bool primaryDrainageSimulation;
@@ -93,7 +128,10 @@ class userInput {
   bool relativePermeabilitiesCalculation;
   bool extractDataSS;
   int twoPhaseSimulationSteps;
+  pcStepping pcSteppingMode;
+  double maxSwChangePerStep;
   double filmConductanceResistivity;
+  int relativePermeabilityWorkers;
 
   // USS / Tracer
   double flowRate;
@@ -103,6 +141,20 @@ class userInput {
   bool enhancedWaterConnectivity;
   double tracerDiffusionCoef;
   bool extractDataUSS;
+  bool eventDrivenUSS;
+  int maxFillingEventsPerSolve;
+  double flowChangeTolerance;
+  bool activeSetSolver;
+  double checkpointInterval;
+  bool checkpointInBackground;
+  bool restartFromCheckpoint;
+  bool binaryResults;
+  double resultsFlushInterval;
+
+  // Output streams (see outputSchedule)
+  outputSettings curvesOutput;
+  outputSettings relativePermeabilitiesOutput;
+  outputSettings networkStatesOutput;
   double oilViscosity;
   double waterViscosity;
   double gasViscosity;
@@ -120,9 +172,33 @@ class userInput {
   int rendererFPS;
   bool keepFrames;
 
+  // Output
+  std::string outputDirectory;  // prefix of the output folders, "" or ".../"
+
  private:
   userInput();
   static userInput instance;
+  static thread_local userInput *active;
+};
+
+class userInput::scope {
+ public:
+  explicit scope(userInput &config);
+  ~scope();
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+  // Worker threads of the parallel loops run from the innermost scope of the
+  // calling thread, started on first use; nullptr outside any scope
+  static parallel::workerPool *getWorkerPool();
+
+ private:
+  userInput *previous;
+  scope *previousScope;
+  std::unique_ptr<parallel::workerPool> workers;
+  static thread_local scope *activeScope;
 };
 
 }  // namespace PNM
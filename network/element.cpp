@@ -10,37 +10,25 @@
 
 namespace PNM {
 
+// Never destroyed: networks may outlive the static storage of this unit
+coldAttributes *element::ownCold = new coldAttributes;
+bool element::statesShared = false;
+thread_local elementStates *element::activeStates = nullptr;
+
 element::element() {
   radius = 0;
   length = 0;
-  theta = 0;
-  wettabilityFlag = wettability::oilWet;
-  phaseFlag = phase::oil;
   volume = 0;
-  capillaryPressure = 0;
-  viscosity = 1;
-  conductivity = 0;
-  concentration = 0;
-  flow = 0;
+  conductivityFactor = 0;
   closed = false;
-  active = true;
   inlet = false;
   outlet = false;
-
-  clusterTemp = 0;
-  clusterOil = nullptr;
-  clusterWater = nullptr;
-  clusterOilWet = nullptr;
-  clusterWaterWet = nullptr;
-
-  oilFraction = 1;
-  waterFraction = 0;
-
-  beta1 = 0;
-  beta2 = 0;
-  beta3 = 0;
 }
 
-element::~element() {}
+element::~element() {
+  if (ownState.filmIndex >= 0) ownCold->films.release(ownState.filmIndex);
+  if (ownState.tracerIndex >= 0)
+    ownCold->tracers.release(ownState.tracerIndex);
+}
 
 }  // namespace PNM
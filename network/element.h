@@ -8,6 +8,8 @@
 #ifndef ELEMENT_H
 #define ELEMENT_H
 
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace PNM {
@@ -18,6 +20,124 @@ enum class capillaryType { throat, poreBody };
 
 class cluster;
 
+// Storage precision of geometric, saturation and concentration attributes.
+// Building with NUMSCAL_FLOAT_STORAGE (CONFIG += float_storage) halves their
+// footprint; pressures, conductivities, flows and accumulators stay in double.
+#ifdef NUMSCAL_FLOAT_STORAGE
+using storageReal = float;
+#else
+using storageReal = double;
+#endif
+
+// Attributes only used by the quasi-steady-state cycle (films/layers and
+// wettability backup). Allocated on first non-default write.
+struct filmAttributes {
+  storageReal beta1 = 0, beta2 = 0, beta3 = 0;
+  storageReal oilFilmVolume = 0, waterFilmVolume = 0;
+  double oilFilmConductivity = 0, waterFilmConductivity = 0;
+  storageReal filmAreaCoefficient = 0;
+  storageReal originalTheta = 0;
+};
+
+// Attributes only used by tracer flow. Allocated on first non-default write.
+struct tracerAttributes {
+  storageReal concentration = 0;
+  double massFlow = 0;
+};
+
+// Side array of one type of cold attribute blocks: an element's block is found
+// through its index in elementState (-1 while unallocated). Released blocks
+// are reused by the next allocations.
+template <typename T>
+struct attributeBlocks {
+  std::vector<T> blocks;
+  std::vector<int> released;
+
+  int allocate() {
+    if (released.empty()) {
+      blocks.emplace_back();
+      return static_cast<int>(blocks.size()) - 1;
+    }
+    int index = released.back();
+    released.pop_back();
+    blocks[index] = T();
+    return index;
+  }
+  void release(int index) { released.push_back(index); }
+};
+
+// Cold attribute blocks of a set of element states
+struct coldAttributes {
+  attributeBlocks<filmAttributes> films;
+  attributeBlocks<tracerAttributes> tracers;
+};
+
+// Per-run attributes of a capillary element: everything a simulation changes,
+// as opposed to the geometry and topology shared by all runs on a network.
+struct elementState {
+  storageReal theta = 0;         // capillary oil-water contact angle
+  double conductivity = 0;       // capillary conductivity (SI)
+  double capillaryPressure = 0;  // capillary pressure across the element (SI)
+  double viscosity = 1;          // capillary average viscosity (SI)
+  bool active = true;  // a flag whether the capillary is momentarily closed
+                       // (i.e. when closing the capillaries with counter
+                       // imbibition flow)
+  wettability wettabilityFlag = wettability::oilWet;  // capillary wettability
+  phase phaseFlag = phase::oil;  // capillary occupying phase
+
+  double flow = 0;                  // fluid flow (SI) in the capillary
+  storageReal oilFraction = 1;      // oil fraction in the capillary
+  storageReal waterFraction = 0;    // water fraction in the capillary
+  storageReal effectiveVolume = 0;  // bulk volume (volume - (film+layer)
+                                    // volume)
+  bool waterTrapped = false;  // a flag to whether water is topologically
+                              // trapped in the capillary
+  bool oilTrapped = false;    // a flag to whether oil is topologically trapped
+                              // in the capillary
+  bool oilCanFlowViaFilm = false,
+       waterCanFlowViaFilm = false;  // flags whether a fluid can flow via
+                                     // layer/film
+  bool oilLayerActivated = false,
+       waterCornerActivated = false;  // flags whether a fluid can flow via
+                                      // layer/film
+  bool oilConductor = false,
+       waterConductor = false;  // flags whether a fluid can flow through the
+                                // capillary - through bulk OR film
+
+  // Pore body attributes
+  double pressure = 0;    // pressure (SI)
+  int rank = 0;           // solver ranking
+  int oilNeighboors = 0;  // oil-filled neighbouring throats (pore-body filling)
+
+  // Throat attributes
+  bool nodeInOil = false;     // flags oil existence at nodeIn
+  bool nodeOutWater = false;  // flags water existence at nodeOut
+  bool nodeInWater = false;   // flags water existence at nodeIn
+  bool nodeOutOil = false;    // flags oil existence at nodeOut
+
+  // Clustering attributes
+  int clusterTemp = 0;
+  cluster *clusterWaterWet = nullptr;
+  cluster *clusterOilWet = nullptr;
+  cluster *clusterWater = nullptr;
+  cluster *clusterOil = nullptr;
+  cluster *clusterWaterFilm = nullptr;
+  cluster *clusterOilFilm = nullptr;
+  cluster *clusterActive = nullptr;
+
+  // Cold attributes, indices in coldAttributes
+  int filmIndex = -1;    // see filmAttributes
+  int tracerIndex = -1;  // see tracerAttributes
+};
+
+// Element states of a whole network, indexed by id - 1, and their cold
+// attribute blocks
+struct elementStates {
+  std::vector<elementState> nodes;
+  std::vector<elementState> pores;
+  coldAttributes cold;
+};
+
 class element {
  public:
   element();
@@ -32,8 +152,8 @@ class element {
 
   capillaryType getType() const { return type; }
 
-  bool getActive() const { return active; }
-  void setActive(bool value) { active = value; }
+  bool getActive() const { return state().active; }
+  void setActive(bool value) { state().active = value; }
 
   bool getInlet() const { return inlet; }
   void setInlet(bool value) { inlet = value; }
@@ -63,123 +183,216 @@ class element {
     entryPressureCoefficient = value;
   }
 
-  double getConductivity() const { return conductivity; }
-  void setConductivity(double value) { conductivity = value; }
+  double getConductivity() const { return state().conductivity; }
+  void setConductivity(double value) { state().conductivity = value; }
 
-  double getCapillaryPressure() const { return capillaryPressure; }
-  void setCapillaryPressure(double value) { capillaryPressure = value; }
+  double getConductivityFactor() const { return conductivityFactor; }
+  void setConductivityFactor(double value) { conductivityFactor = value; }
 
-  double getTheta() const { return theta; }
-  void setTheta(double value) { theta = value; }
+  double getCapillaryPressure() const { return state().capillaryPressure; }
+  void setCapillaryPressure(double value) { state().capillaryPressure = value; }
 
-  double getOriginalTheta() const { return originalTheta; }
-  void setOriginalTheta(double value) { originalTheta = value; }
+  double getTheta() const { return state().theta; }
+  void setTheta(double value) { state().theta = value; }
 
-  wettability getWettabilityFlag() const { return wettabilityFlag; }
-  void setWettabilityFlag(wettability value) { wettabilityFlag = value; }
+  double getOriginalTheta() const {
+    return getFilmAttribute(&filmAttributes::originalTheta);
+  }
+  void setOriginalTheta(double value) {
+    setFilmAttribute(&filmAttributes::originalTheta, value);
+  }
 
-  phase getPhaseFlag() const { return phaseFlag; }
-  void setPhaseFlag(phase value) { phaseFlag = value; }
+  wettability getWettabilityFlag() const { return state().wettabilityFlag; }
+  void setWettabilityFlag(wettability value) {
+    state().wettabilityFlag = value;
+  }
 
-  double getConcentration() const { return concentration; }
-  void setConcentration(double value) { concentration = value; }
+  phase getPhaseFlag() const { return state().phaseFlag; }
+  void setPhaseFlag(phase value) { state().phaseFlag = value; }
 
-  double getViscosity() const { return viscosity; }
-  void setViscosity(double value) { viscosity = value; }
+  double getConcentration() const {
+    return getTracerAttribute(&tracerAttributes::concentration);
+  }
+  void setConcentration(double value) {
+    setTracerAttribute(&tracerAttributes::concentration, value);
+  }
 
-  double getOilFraction() const { return oilFraction; }
-  void setOilFraction(double value) { oilFraction = value; }
+  double getViscosity() const { return state().viscosity; }
+  void setViscosity(double value) { state().viscosity = value; }
 
-  double getWaterFraction() const { return waterFraction; }
-  void setWaterFraction(double value) { waterFraction = value; }
+  double getOilFraction() const { return state().oilFraction; }
+  void setOilFraction(double value) { state().oilFraction = value; }
 
-  bool getWaterTrapped() const { return waterTrapped; }
-  void setWaterTrapped(bool value) { waterTrapped = value; }
+  double getWaterFraction() const { return state().waterFraction; }
+  void setWaterFraction(double value) { state().waterFraction = value; }
 
-  bool getOilTrapped() const { return oilTrapped; }
-  void setOilTrapped(bool value) { oilTrapped = value; }
+  bool getWaterTrapped() const { return state().waterTrapped; }
+  void setWaterTrapped(bool value) { state().waterTrapped = value; }
 
-  double getFlow() const { return flow; }
-  void setFlow(double value) { flow = value; }
+  bool getOilTrapped() const { return state().oilTrapped; }
+  void setOilTrapped(bool value) { state().oilTrapped = value; }
 
-  double getMassFlow() const { return massFlow; }
-  void setMassFlow(double value) { massFlow = value; }
+  double getFlow() const { return state().flow; }
+  void setFlow(double value) { state().flow = value; }
 
-  double getBeta1() const { return beta1; }
-  void setBeta1(double value) { beta1 = value; }
+  double getMassFlow() const {
+    return getTracerAttribute(&tracerAttributes::massFlow);
+  }
+  void setMassFlow(double value) {
+    setTracerAttribute(&tracerAttributes::massFlow, value);
+  }
 
-  double getBeta2() const { return beta2; }
-  void setBeta2(double value) { beta2 = value; }
+  double getBeta1() const { return getFilmAttribute(&filmAttributes::beta1); }
+  void setBeta1(double value) {
+    setFilmAttribute(&filmAttributes::beta1, value);
+  }
 
-  double getBeta3() const { return beta3; }
-  void setBeta3(double value) { beta3 = value; }
+  double getBeta2() const { return getFilmAttribute(&filmAttributes::beta2); }
+  void setBeta2(double value) {
+    setFilmAttribute(&filmAttributes::beta2, value);
+  }
 
-  double getEffectiveVolume() const { return effectiveVolume; }
-  void setEffectiveVolume(double value) { effectiveVolume = value; }
+  double getBeta3() const { return getFilmAttribute(&filmAttributes::beta3); }
+  void setBeta3(double value) {
+    setFilmAttribute(&filmAttributes::beta3, value);
+  }
 
-  double getOilFilmVolume() const { return oilFilmVolume; }
-  void setOilFilmVolume(double value) { oilFilmVolume = value; }
+  double getEffectiveVolume() const { return state().effectiveVolume; }
+  void setEffectiveVolume(double value) { state().effectiveVolume = value; }
 
-  double getWaterFilmVolume() const { return waterFilmVolume; }
-  void setWaterFilmVolume(double value) { waterFilmVolume = value; }
+  double getOilFilmVolume() const {
+    return getFilmAttribute(&filmAttributes::oilFilmVolume);
+  }
+  void setOilFilmVolume(double value) {
+    setFilmAttribute(&filmAttributes::oilFilmVolume, value);
+  }
 
-  double getFilmAreaCoefficient() const { return filmAreaCoefficient; }
-  void setFilmAreaCoefficient(double value) { filmAreaCoefficient = value; }
+  double getWaterFilmVolume() const {
+    return getFilmAttribute(&filmAttributes::waterFilmVolume);
+  }
+  void setWaterFilmVolume(double value) {
+    setFilmAttribute(&filmAttributes::waterFilmVolume, value);
+  }
 
-  bool getOilCanFlowViaFilm() const { return oilCanFlowViaFilm; }
-  void setOilCanFlowViaFilm(bool value) { oilCanFlowViaFilm = value; }
+  double getFilmAreaCoefficient() const {
+    return getFilmAttribute(&filmAttributes::filmAreaCoefficient);
+  }
+  void setFilmAreaCoefficient(double value) {
+    setFilmAttribute(&filmAttributes::filmAreaCoefficient, value);
+  }
+
+  bool getOilCanFlowViaFilm() const { return state().oilCanFlowViaFilm; }
+  void setOilCanFlowViaFilm(bool value) { state().oilCanFlowViaFilm = value; }
 
-  bool getWaterCanFlowViaFilm() const { return waterCanFlowViaFilm; }
-  void setWaterCanFlowViaFilm(bool value) { waterCanFlowViaFilm = value; }
+  bool getWaterCanFlowViaFilm() const { return state().waterCanFlowViaFilm; }
+  void setWaterCanFlowViaFilm(bool value) {
+    state().waterCanFlowViaFilm = value;
+  }
 
-  bool getWaterCornerActivated() const { return waterCornerActivated; }
-  void setWaterCornerActivated(bool value) { waterCornerActivated = value; }
+  bool getWaterCornerActivated() const { return state().waterCornerActivated; }
+  void setWaterCornerActivated(bool value) {
+    state().waterCornerActivated = value;
+  }
 
-  bool getOilLayerActivated() const { return oilLayerActivated; }
-  void setOilLayerActivated(bool value) { oilLayerActivated = value; }
+  bool getOilLayerActivated() const { return state().oilLayerActivated; }
+  void setOilLayerActivated(bool value) { state().oilLayerActivated = value; }
 
-  bool getWaterConductor() const { return waterConductor; }
-  void setWaterConductor(bool value) { waterConductor = value; }
+  bool getWaterConductor() const { return state().waterConductor; }
+  void setWaterConductor(bool value) { state().waterConductor = value; }
 
-  bool getOilConductor() const { return oilConductor; }
-  void setOilConductor(bool value) { oilConductor = value; }
+  bool getOilConductor() const { return state().oilConductor; }
+  void setOilConductor(bool value) { state().oilConductor = value; }
 
-  double getOilFilmConductivity() const { return oilFilmConductivity; }
-  void setOilFilmConductivity(double value) { oilFilmConductivity = value; }
+  double getOilFilmConductivity() const {
+    return getFilmAttribute(&filmAttributes::oilFilmConductivity);
+  }
+  void setOilFilmConductivity(double value) {
+    setFilmAttribute(&filmAttributes::oilFilmConductivity, value);
+  }
 
-  double getWaterFilmConductivity() const { return waterFilmConductivity; }
-  void setWaterFilmConductivity(double value) { waterFilmConductivity = value; }
+  double getWaterFilmConductivity() const {
+    return getFilmAttribute(&filmAttributes::waterFilmConductivity);
+  }
+  void setWaterFilmConductivity(double value) {
+    setFilmAttribute(&filmAttributes::waterFilmConductivity, value);
+  }
 
   // clustering methods
-  int getClusterTemp() const { return clusterTemp; }
-  void setClusterTemp(int value) { clusterTemp = value; }
+  int getClusterTemp() const { return state().clusterTemp; }
+  void setClusterTemp(int value) { state().clusterTemp = value; }
 
-  cluster *getClusterActive() const { return clusterActive; }
-  void setClusterActive(cluster *value) { clusterActive = value; }
+  cluster *getClusterActive() const { return state().clusterActive; }
+  void setClusterActive(cluster *value) { state().clusterActive = value; }
 
-  cluster *getClusterWaterWet() const { return clusterWaterWet; }
-  void setClusterWaterWet(cluster *value) { clusterWaterWet = value; }
+  cluster *getClusterWaterWet() const { return state().clusterWaterWet; }
+  void setClusterWaterWet(cluster *value) { state().clusterWaterWet = value; }
 
-  cluster *getClusterOilWet() const { return clusterOilWet; }
-  void setClusterOilWet(cluster *value) { clusterOilWet = value; }
+  cluster *getClusterOilWet() const { return state().clusterOilWet; }
+  void setClusterOilWet(cluster *value) { state().clusterOilWet = value; }
 
-  cluster *getClusterWater() const { return clusterWater; }
-  void setClusterWater(cluster *value) { clusterWater = value; }
+  cluster *getClusterWater() const { return state().clusterWater; }
+  void setClusterWater(cluster *value) { state().clusterWater = value; }
 
-  cluster *getClusterOil() const { return clusterOil; }
-  void setClusterOil(cluster *value) { clusterOil = value; }
+  cluster *getClusterOil() const { return state().clusterOil; }
+  void setClusterOil(cluster *value) { state().clusterOil = value; }
 
-  cluster *getClusterWaterConductor() const { return clusterWaterFilm; }
-  void setClusterWaterFilm(cluster *value) { clusterWaterFilm = value; }
+  cluster *getClusterWaterConductor() const { return state().clusterWaterFilm; }
+  void setClusterWaterFilm(cluster *value) { state().clusterWaterFilm = value; }
 
-  cluster *getClusterOilConductor() const { return clusterOilFilm; }
-  void setClusterOilFilm(cluster *value) { clusterOilFilm = value; }
+  cluster *getClusterOilConductor() const { return state().clusterOilFilm; }
+  void setClusterOilFilm(cluster *value) { state().clusterOilFilm = value; }
 
   std::vector<element *> &getNeighboors() { return neighboors; }
   void setNeighboors(const std::vector<element *> &value) {
     neighboors = value;
   }
 
+  // cold attribute blocks
+  bool hasFilmAttributes() const { return state().filmIndex >= 0; }
+  void releaseFilmAttributes() {
+    elementState &s = state();
+    if (s.filmIndex < 0) return;
+    cold().films.release(s.filmIndex);
+    s.filmIndex = -1;
+  }
+
+  bool hasTracerAttributes() const { return state().tracerIndex >= 0; }
+  void releaseTracerAttributes() {
+    elementState &s = state();
+    if (s.tracerIndex < 0) return;
+    cold().tracers.release(s.tracerIndex);
+    s.tracerIndex = -1;
+  }
+
+  // Exchanges the element's own per-run attributes with the given ones, see
+  // networkState::scope
+  void swapState(elementState &other) { std::swap(ownState, other); }
+  // Same for the cold attribute blocks of the elements' own states
+  static void swapColdAttributes(coldAttributes &other) {
+    std::swap(*ownCold, other);
+  }
+
+  // Cold attribute blocks of the states returned by the state accessors
+  static coldAttributes &cold() {
+    return statesShared && activeStates ? activeStates->cold : *ownCold;
+  }
+
+  // While shared, the per-run attributes of every element are routed to the
+  // states activated on the calling thread (nullptr: the elements' own), so
+  // that concurrent runs can share them, see networkState::concurrentRuns
+  static bool getStatesShared() { return statesShared; }
+  static bool shareStates(bool value) {
+    bool previous = statesShared;
+    statesShared = value;
+    return previous;
+  }
+  static elementStates *getActiveStates() { return activeStates; }
+  static elementStates *activateStates(elementStates *states) {
+    elementStates *previous = activeStates;
+    activeStates = states;
+    return previous;
+  }
+
  protected:
   capillaryType
       type;  // type of the capillary element: pore (throat) or pore body (node)
@@ -187,61 +400,71 @@ class element {
   // Basic attributes
   int id;  // capillary relative ID: from 1 to totalPores (if pore); from 1 to
            // totalNodes (if node)
-  double radius;       // capillary radius (SI)
-  double length;       // capillary length (SI)
-  double volume;       // capillary volume (SI)
-  double shapeFactor;  // capillary shape factor (dimensionless)
-  double
+  storageReal radius;       // capillary radius (SI)
+  storageReal length;       // capillary length (SI)
+  storageReal volume;       // capillary volume (SI)
+  storageReal shapeFactor;  // capillary shape factor (dimensionless)
+  storageReal
       shapeFactorConstant;  // capillary shape factor constant (dimensionless)
-  double entryPressureCoefficient;  // 1 + 2 * sqrt(pi * shapeFactor)
-  double conductivity;              // capillary conductivity (SI)
-  double capillaryPressure;     // capillary pressure across the element (SI)
-  double theta, originalTheta;  // capillary oil-water contact angle
-  double viscosity;             // capillary average viscosity (SI)
-  double concentration;  // capillary concentration in tracer (between 0 and 1)
+  storageReal entryPressureCoefficient;  // 1 + 2 * sqrt(pi * shapeFactor)
+  double conductivityFactor;  // bulk conductivity at unit viscosity (SI)
   bool
       inlet;  // a flag whether the capillary is connected to the inlet boundary
   bool outlet;  // a flag whether the capillary is connected to the outlet
                 // boundary
   bool closed;  // a flag whether the capillary is undefinetely closed (i.e.
                 // when assigning the coordination number)
-  bool active;  // a flag whether the capillary is momentarily closed (i.e. when
-                // closing the capillaries with counter imbibition flow)
-  wettability wettabilityFlag;  // capillary wettability
-  phase phaseFlag;              // capillary occupying phase
   std::vector<element *> neighboors;
 
-  // Simulation attributes
-  double oilFraction;                     // oil fraction in the capillary
-  double waterFraction;                   // water fraction in the capillary
-  double flow;                            // fluid flow (SI) in the capillary
-  double massFlow;                        // mass flow (SI) in the capillary
-  double beta1, beta2, beta3;             // half angles in the capillary
-  double oilFilmVolume, waterFilmVolume;  // layer/film volumes
-  double oilFilmConductivity, waterFilmConductivity;  // layer/film conductivity
-  double effectiveVolume;      // bulk volume (volume - (film+layer) volume)
-  double filmAreaCoefficient;  // a mathematical coefficient used in the
-                               // calculation of film area (Oren, 98)
-  bool waterTrapped;  // a flag to whether water is topologically trapped in the
-                      // capillary
-  bool oilTrapped;    // a flag to whether oil is topologically trapped in the
-                      // capillary
-  bool oilCanFlowViaFilm,
-      waterCanFlowViaFilm;  // flags whether a fluid can flow via layer/film
-  bool oilLayerActivated,
-      waterCornerActivated;  // flags whether a fluid can flow via layer/film
-  bool oilConductor, waterConductor;  // flags whether a fluid can flow through
-                                      // the capillary - through bulk OR film
+  // Per-run attributes: the element's own, unless concurrent runs share the
+  // elements and this thread has active elementStates
+  elementState &state() {
+    if (!statesShared) return ownState;
+    return activeStates ? (type == capillaryType::throat
+                               ? activeStates->pores
+                               : activeStates->nodes)[id - 1]
+                        : ownState;
+  }
+  const elementState &state() const {
+    return const_cast<element *>(this)->state();
+  }
 
-  // Clustering attributes
-  int clusterTemp;
-  cluster *clusterWaterWet;
-  cluster *clusterOilWet;
-  cluster *clusterWater;
-  cluster *clusterOil;
-  cluster *clusterWaterFilm;
-  cluster *clusterOilFilm;
-  cluster *clusterActive;
+ private:
+  template <typename T>
+  double getFilmAttribute(T filmAttributes::*attribute) const {
+    int index = state().filmIndex;
+    return index < 0 ? 0 : cold().films.blocks[index].*attribute;
+  }
+  template <typename T>
+  void setFilmAttribute(T filmAttributes::*attribute, double value) {
+    elementState &s = state();
+    if (s.filmIndex < 0) {
+      if (value == 0) return;
+      s.filmIndex = cold().films.allocate();
+    }
+    cold().films.blocks[s.filmIndex].*attribute = value;
+  }
+
+  template <typename T>
+  double getTracerAttribute(T tracerAttributes::*attribute) const {
+    int index = state().tracerIndex;
+    return index < 0 ? 0 : cold().tracers.blocks[index].*attribute;
+  }
+  template <typename T>
+  void setTracerAttribute(T tracerAttributes::*attribute, double value) {
+    elementState &s = state();
+    if (s.tracerIndex < 0) {
+      if (value == 0) return;
+      s.tracerIndex = cold().tracers.allocate();
+    }
+    cold().tracers.blocks[s.tracerIndex].*attribute = value;
+  }
+
+  elementState ownState;
+
+  static coldAttributes *ownCold;  // blocks of the elements' own states
+  static bool statesShared;
+  static thread_local elementStates *activeStates;
 };
 
 }  // namespace PNM
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ELEMENTSET_H
+#define ELEMENTSET_H
+
+#include "iterator.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace PNM {
+
+// Set of network elements stored as a membership bitmap plus a compact list.
+// Iteration follows the network order (the order of pnmRange<T>) whatever
+// the insertion order, inserting never allocates once the list has grown,
+// and clearing only touches the current members.
+template <typename T>
+class elementSet {
+ public:
+  using iterator = typename std::vector<T *>::const_iterator;
+
+  void initialise(networkPtr net) {
+    clear();
+    poreOffset = std::is_same<T, element>::value ? net->totalNodes : 0;
+    int size = std::is_same<T, node>::value
+                   ? net->totalNodes
+                   : std::is_same<T, pore>::value
+                         ? net->totalPores
+                         : net->totalNodes + net->totalPores;
+    members.assign(size, false);
+    list.reserve(size);
+  }
+
+  bool insert(T *e) {
+    int i = index(e);
+    if (members[i]) return false;
+    members[i] = true;
+    if (!list.empty() && index(list.back()) > i) sorted = false;
+    list.push_back(e);
+    return true;
+  }
+
+  bool erase(T *e) {
+    int i = index(e);
+    if (!members[i]) return false;
+    members[i] = false;
+    list.erase(std::find(list.begin(), list.end(), e));
+    return true;
+  }
+
+  bool contains(T *e) const { return members[index(e)]; }
+
+  void clear() {
+    for (T *e : list) members[index(e)] = false;
+    list.clear();
+    sorted = true;
+  }
+
+  bool empty() const { return list.empty(); }
+  size_t size() const { return list.size(); }
+
+  iterator begin() {
+    sort();
+    return list.cbegin();
+  }
+  iterator end() { return list.cend(); }
+
+ protected:
+  int index(T *e) const {
+    return e->getType() == capillaryType::throat ? poreOffset + e->getId() - 1
+                                                 : e->getId() - 1;
+  }
+
+  void sort() {
+    if (sorted) return;
+    std::sort(list.begin(), list.end(),
+              [this](T *a, T *b) { return index(a) < index(b); });
+    sorted = true;
+  }
+
+  std::vector<bool> members;
+  std::vector<T *> list;
+  int poreOffset = 0;
+  bool sorted = true;
+};
+
+}  // namespace PNM
+
+#endif  // ELEMENTSET_H
@@ -8,6 +8,7 @@
 #ifndef NETWORKMODEL_H
 #define NETWORKMODEL_H
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -46,6 +47,16 @@ struct networkModel {
   std::vector<nodePtr> tableOfNodes;
   std::vector<pore *> inletPores;
   std::vector<pore *> outletPores;
+
+  ///////////// Id mapping (filled when the network has been reordered)
+
+  std::vector<int> nodeSourceIds;  // id in the source network of each node
+  std::vector<int> poreSourceIds;  // id in the source network of each pore
+
+  ///////////// Revisions (bumped whenever contact angles are reassigned, by
+  ///////////// any of the runs sharing the network)
+
+  std::atomic<unsigned> wettabilityRevision{0};
 };
 
 }  // namespace PNM
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "networkstate.h"
+#include "iterator.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace PNM {
+
+std::shared_ptr<networkState> networkState::capture(
+    std::shared_ptr<networkModel> network) {
+  std::shared_ptr<networkState> state(new networkState);
+  state->network = network;
+
+  auto elements = std::make_shared<std::vector<savedElement>>();
+  elements->reserve(network->totalNodes + network->totalPores);
+  for (element *e : pnmRange<element>(network)) {
+    savedElement s;
+    s.phaseFlag = e->getPhaseFlag();
+    s.wettabilityFlag = e->getWettabilityFlag();
+    s.theta = e->getTheta();
+    s.oilFraction = e->getOilFraction();
+    s.waterFraction = e->getWaterFraction();
+    s.viscosity = e->getViscosity();
+    s.conductivity = e->getConductivity();
+    s.capillaryPressure = e->getCapillaryPressure();
+    s.flow = e->getFlow();
+    s.effectiveVolume = e->getEffectiveVolume();
+    s.concentration = e->getConcentration();
+    s.active = e->getActive();
+    s.waterTrapped = e->getWaterTrapped();
+    s.oilTrapped = e->getOilTrapped();
+    s.oilCanFlowViaFilm = e->getOilCanFlowViaFilm();
+    s.waterCanFlowViaFilm = e->getWaterCanFlowViaFilm();
+    s.oilLayerActivated = e->getOilLayerActivated();
+    s.waterCornerActivated = e->getWaterCornerActivated();
+    s.oilConductor = e->getOilConductor();
+    s.waterConductor = e->getWaterConductor();
+    elements->push_back(s);
+  }
+
+  auto pores = std::make_shared<std::vector<savedPore>>();
+  pores->reserve(network->totalPores);
+  for (pore *p : pnmRange<pore>(network)) {
+    savedPore s;
+    s.nodeInOil = p->getNodeInOil();
+    s.nodeOutOil = p->getNodeOutOil();
+    s.nodeInWater = p->getNodeInWater();
+    s.nodeOutWater = p->getNodeOutWater();
+    pores->push_back(s);
+  }
+
+  auto nodePressures = std::make_shared<std::vector<double>>();
+  nodePressures->reserve(network->totalNodes);
+  for (node *n : pnmRange<node>(network))
+    nodePressures->push_back(n->getPressure());
+
+  state->elements = elements;
+  state->pores = pores;
+  state->nodePressures = nodePressures;
+
+  return state;
+}
+
+void networkState::restore() const {
+  // Cold attribute blocks are not part of the snapshot: they are released
+  // and reallocated on demand by the next simulation that needs them.
+  auto elementIt = elements->begin();
+  for (element *e : pnmRange<element>(network)) {
+    const savedElement &s = *elementIt++;
+    e->releaseFilmAttributes();
+    e->releaseTracerAttributes();
+    e->setPhaseFlag(s.phaseFlag);
+    e->setWettabilityFlag(s.wettabilityFlag);
+    e->setTheta(s.theta);
+    e->setOilFraction(s.oilFraction);
+    e->setWaterFraction(s.waterFraction);
+    e->setViscosity(s.viscosity);
+    e->setConductivity(s.conductivity);
+    e->setCapillaryPressure(s.capillaryPressure);
+    e->setFlow(s.flow);
+    e->setEffectiveVolume(s.effectiveVolume);
+    e->setConcentration(s.concentration);
+    e->setActive(s.active);
+    e->setWaterTrapped(s.waterTrapped);
+    e->setOilTrapped(s.oilTrapped);
+    e->setOilCanFlowViaFilm(s.oilCanFlowViaFilm);
+    e->setWaterCanFlowViaFilm(s.waterCanFlowViaFilm);
+    e->setOilLayerActivated(s.oilLayerActivated);
+    e->setWaterCornerActivated(s.waterCornerActivated);
+    e->setOilConductor(s.oilConductor);
+    e->setWaterConductor(s.waterConductor);
+  }
+
+  auto poreIt = pores->begin();
+  for (pore *p : pnmRange<pore>(network)) {
+    const savedPore &s = *poreIt++;
+    p->setNodeInOil(s.nodeInOil);
+    p->setNodeOutOil(s.nodeOutOil);
+    p->setNodeInWater(s.nodeInWater);
+    p->setNodeOutWater(s.nodeOutWater);
+  }
+
+  auto pressureIt = nodePressures->begin();
+  for (node *n : pnmRange<node>(network)) n->setPressure(*pressureIt++);
+
+  network->wettabilityRevision++;
+}
+
+namespace {
+
+void swapStates(std::shared_ptr<networkModel> network, elementStates &states) {
+  for (node *n : pnmRange<node>(network))
+    n->swapState(states.nodes[n->getId() - 1]);
+  for (pore *p : pnmRange<pore>(network))
+    p->swapState(states.pores[p->getId() - 1]);
+  element::swapColdAttributes(states.cold);
+}
+
+}  // namespace
+
+networkState::scope::scope(const networkState &initial)
+    : network(initial.network) {
+  states.nodes.resize(network->totalNodes);
+  states.pores.resize(network->totalPores);
+  previous = element::getActiveStates();
+  swapped = !element::getStatesShared();
+  if (swapped)
+    swapStates(network, states);
+  else
+    element::activateStates(&states);
+  initial.restore();
+}
+
+networkState::scope::~scope() {
+  if (swapped) swapStates(network, states);
+  element::activateStates(previous);
+}
+
+namespace {
+
+template <typename T>
+void writeVector(std::ostream &out, const std::vector<T> &values) {
+  uint64_t size = values.size();
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  out.write(reinterpret_cast<const char *>(values.data()),
+            size * sizeof(T));
+}
+
+template <typename T>
+std::shared_ptr<const std::vector<T>> readVector(std::istream &in,
+                                                 size_t expectedSize) {
+  uint64_t size(0);
+  in.read(reinterpret_cast<char *>(&size), sizeof(size));
+  if (!in || size != expectedSize)
+    throw std::runtime_error("Network state doesn't match the network");
+  auto values = std::make_shared<std::vector<T>>(size);
+  in.read(reinterpret_cast<char *>(values->data()), size * sizeof(T));
+  if (!in) throw std::runtime_error("Truncated network state");
+  return values;
+}
+
+}  // namespace
+
+void networkState::write(std::ostream &out) const {
+  writeVector(out, *elements);
+  writeVector(out, *pores);
+  writeVector(out, *nodePressures);
+}
+
+std::shared_ptr<networkState> networkState::read(
+    std::shared_ptr<networkModel> network, std::istream &in) {
+  std::shared_ptr<networkState> state(new networkState);
+  state->network = network;
+  state->elements = readVector<savedElement>(
+      in, network->totalNodes + network->totalPores);
+  state->pores = readVector<savedPore>(in, network->totalPores);
+  state->nodePressures = readVector<double>(in, network->totalNodes);
+  return state;
+}
+
+}  // namespace PNM
@@ -0,0 +1,118 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef NETWORKSTATE_H
+#define NETWORKSTATE_H
+
+#include "element.h"
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+namespace PNM {
+
+class networkModel;
+
+// Snapshot of the mutable simulation state of a network (phases, fractions,
+// wettability, flow, pressures, flags). The network geometry and topology are
+// not copied: a snapshot only references the network it was captured from.
+// Snapshots are immutable once captured, so copies share the same storage.
+// write/read use a raw binary layout that is only meant to be read back by
+// the same build on the same network.
+//
+// A networkState::scope gives the calling thread its own per-run element
+// states (see elementState), initialised from a snapshot, so that concurrent
+// runs share one network and only duplicate what they change. The states of a
+// run are swapped into the elements for the lifetime of its scope, so that
+// their accessors reach them directly; while concurrent runs share the
+// elements (see concurrentRuns), each reaches its states through its thread.
+class networkState {
+ public:
+  class scope;
+  class concurrentRuns;
+
+  static std::shared_ptr<networkState> capture(std::shared_ptr<networkModel>);
+  void restore() const;
+  void write(std::ostream &) const;
+  static std::shared_ptr<networkState> read(std::shared_ptr<networkModel>,
+                                            std::istream &);
+  std::shared_ptr<networkModel> getNetwork() const { return network; }
+
+ protected:
+  struct savedElement {
+    phase phaseFlag;
+    wettability wettabilityFlag;
+    double theta;
+    double oilFraction;
+    double waterFraction;
+    double viscosity;
+    double conductivity;
+    double capillaryPressure;
+    double flow;
+    double effectiveVolume;
+    double concentration;
+    bool active;
+    bool waterTrapped;
+    bool oilTrapped;
+    bool oilCanFlowViaFilm;
+    bool waterCanFlowViaFilm;
+    bool oilLayerActivated;
+    bool waterCornerActivated;
+    bool oilConductor;
+    bool waterConductor;
+  };
+
+  struct savedPore {
+    bool nodeInOil;
+    bool nodeOutOil;
+    bool nodeInWater;
+    bool nodeOutWater;
+  };
+
+  networkState() {}
+
+  std::shared_ptr<networkModel> network;
+  std::shared_ptr<const std::vector<savedElement>> elements;
+  std::shared_ptr<const std::vector<savedPore>> pores;
+  std::shared_ptr<const std::vector<double>> nodePressures;
+};
+
+class networkState::scope {
+ public:
+  explicit scope(const networkState &initial);
+  ~scope();
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  std::shared_ptr<networkModel> network;
+  elementStates states;  // the elements' own while swapped in
+  elementStates *previous;
+  bool swapped;
+};
+
+// Shares the elements of every network between the scopes of concurrent runs
+// while it lives
+class networkState::concurrentRuns {
+ public:
+  concurrentRuns() : previous(element::shareStates(true)) {}
+  ~concurrentRuns() { element::shareStates(previous); }
+  concurrentRuns(const concurrentRuns &) = delete;
+  concurrentRuns(concurrentRuns &&) = delete;
+  auto operator=(const concurrentRuns &) -> concurrentRuns & = delete;
+  auto operator=(concurrentRuns &&) -> concurrentRuns & = delete;
+
+ private:
+  bool previous;
+};
+
+}  // namespace PNM
+
+#endif  // NETWORKSTATE_H
@@ -18,8 +18,6 @@ node::node(double X, double Y, double Z) {
   yCoordinate = Y;
   zCoordinate = Z;
   connectionNumber = 6;
-  pressure = 0;
-  rank = 0;
 }
 
 node::~node() {}
@@ -42,25 +42,25 @@ class node : public element {
   int getConnectionNumber() const { return connectionNumber; }
   void setConnectionNumber(int value) { connectionNumber = value; }
 
-  double getPressure() const { return pressure; }
-  void setPressure(double value) { pressure = value; }
+  double getPressure() const { return state().pressure; }
+  void setPressure(double value) { state().pressure = value; }
 
-  int getRank() const { return rank; }
-  void setRank(int value) { rank = value; }
+  int getRank() const { return state().rank; }
+  void setRank(int value) { state().rank = value; }
+
+  int getOilNeighboors() const { return state().oilNeighboors; }
+  void setOilNeighboors(int value) { state().oilNeighboors = value; }
 
  private:
   int x;  // relative x coordinate
   int y;  // relative y coordinate
   int z;  // relative z coordinate
 
-  double xCoordinate;  // absolute x coordinate
-  double yCoordinate;  // absolute y coordinate
-  double zCoordinate;  // absolute z coordinate
+  storageReal xCoordinate;  // absolute x coordinate
+  storageReal yCoordinate;  // absolute y coordinate
+  storageReal zCoordinate;  // absolute z coordinate
 
   int connectionNumber;  // coordination number
-
-  double pressure;  // pressure (SI)
-  int rank;         // solver ranking
 };
 
 }  // namespace PNM
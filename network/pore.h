@@ -37,17 +37,17 @@ class pore : public element {
   double getFullLength() const { return fullLength; }
   void setFullLength(double value) { fullLength = value; }
 
-  bool getNodeInOil() const { return nodeInOil; }
-  void setNodeInOil(bool value) { nodeInOil = value; }
+  bool getNodeInOil() const { return state().nodeInOil; }
+  void setNodeInOil(bool value) { state().nodeInOil = value; }
 
-  bool getNodeOutWater() const { return nodeOutWater; }
-  void setNodeOutWater(bool value) { nodeOutWater = value; }
+  bool getNodeOutWater() const { return state().nodeOutWater; }
+  void setNodeOutWater(bool value) { state().nodeOutWater = value; }
 
-  bool getNodeInWater() const { return nodeInWater; }
-  void setNodeInWater(bool value) { nodeInWater = value; }
+  bool getNodeInWater() const { return state().nodeInWater; }
+  void setNodeInWater(bool value) { state().nodeInWater = value; }
 
-  bool getNodeOutOil() const { return nodeOutOil; }
-  void setNodeOutOil(bool value) { nodeOutOil = value; }
+  bool getNodeOutOil() const { return state().nodeOutOil; }
+  void setNodeOutOil(bool value) { state().nodeOutOil = value; }
 
   // implemented methods
 
@@ -67,13 +67,8 @@ class pore : public element {
  protected:
   node *nodeIn;       // node pointer at the first end of the pore
   node *nodeOut;      // node pointer at the second end of the pore
-  double fullLength;  // distance (SI) between both connecting nodes centers
-
-  // simulation related attributes
-  bool nodeInOil;     // flags oil existence at nodeIn
-  bool nodeOutWater;  // flags water existence at nodeOut
-  bool nodeInWater;   // flags water existence at nodeIn
-  bool nodeOutOil;    // flags oil existence at nodeOut
+  storageReal fullLength;  // distance (SI) between both connecting nodes
+                           // centers
 };
 
 }  // namespace PNM
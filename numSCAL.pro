@@ -19,6 +19,11 @@ CONFIG += c++14
 
 TEMPLATE = app
 
+# Store geometry and saturation attributes in single precision
+float_storage {
+    DEFINES += NUMSCAL_FLOAT_STORAGE
+}
+
 win32 {
     contains(QT_ARCH, i386) {
         #32 bit
@@ -51,13 +56,19 @@ SOURCES += main.cpp \
     network/cluster.cpp \
     network/element.cpp \
     network/networkmodel.cpp \
+    network/networkstate.cpp \
     network/node.cpp \
     network/pore.cpp \
     operations/hkClustering.cpp \
     operations/pnmOperation.cpp \
     operations/pnmSolver.cpp \
+    operations/thresholdTable.cpp \
+    simulations/scenario-batch/scenarioBatchSimulation.cpp \
     simulations/steady-state-cycle/forcedWaterInjection.cpp \
+    simulations/steady-state-cycle/invasionFrontier.cpp \
     simulations/steady-state-cycle/primaryDrainage.cpp \
+    simulations/steady-state-cycle/quasiStaticSimulation.cpp \
+    simulations/steady-state-cycle/relativePermeabilityWorkers.cpp \
     simulations/steady-state-cycle/secondaryOilDrainage.cpp \
     simulations/steady-state-cycle/spontaneousImbibtion.cpp \
     simulations/steady-state-cycle/spontaneousOilInvasion.cpp \
@@ -68,6 +79,11 @@ SOURCES += main.cpp \
     simulations/simulation.cpp \
     simulations/renderer/renderer.cpp \
     misc/maths.cpp \
+    misc/memoryReport.cpp \
+    misc/checkpoint.cpp \
+    misc/parallel.cpp \
+    misc/resultsWriter.cpp \
+    misc/outputSchedule.cpp \
     libs/qcustomplot/qcustomplot.cpp
 
 
@@ -79,6 +95,11 @@ HEADERS += \
     gui/mainwindow.h \
     gui/widget3d.h \
     misc/maths.h \
+    misc/memoryReport.h \
+    misc/checkpoint.h \
+    misc/parallel.h \
+    misc/resultsWriter.h \
+    misc/outputSchedule.h \
     misc/randomGenerator.h \
     misc/scopedtimer.h \
     misc/shader.h \
@@ -86,15 +107,22 @@ HEADERS += \
     misc/userInput.h \
     network/cluster.h \
     network/element.h \
+    network/elementset.h \
     network/iterator.h \
     network/networkmodel.h \
+    network/networkstate.h \
     network/node.h \
     network/pore.h \
     operations/hkClustering.h \
     operations/pnmOperation.h \
     operations/pnmSolver.h \
+    operations/thresholdTable.h \
+    simulations/scenario-batch/scenarioBatchSimulation.h \
     simulations/steady-state-cycle/forcedWaterInjection.h \
+    simulations/steady-state-cycle/invasionFrontier.h \
     simulations/steady-state-cycle/primaryDrainage.h \
+    simulations/steady-state-cycle/quasiStaticSimulation.h \
+    simulations/steady-state-cycle/relativePermeabilityWorkers.h \
     simulations/steady-state-cycle/secondaryOilDrainage.h \
     simulations/steady-state-cycle/spontaneousImbibtion.h \
     simulations/steady-state-cycle/spontaneousOilInvasion.h \
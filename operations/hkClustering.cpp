@@ -15,10 +15,12 @@
 namespace PNM {
 
 hkClustering hkClustering::instance;
+thread_local hkClustering *hkClustering::active = nullptr;
 
 hkClustering &hkClustering::get(std::shared_ptr<networkModel> network) {
-  instance.network = network;
-  return instance;
+  hkClustering &target = active ? *active : instance;
+  target.network = network;
+  return target;
 }
 
 void hkClustering::clusterWaterWetElements() {
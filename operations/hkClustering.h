@@ -21,6 +21,8 @@ using clusterPtr = std::shared_ptr<cluster>;
 
 class hkClustering {
  public:
+  class scope;
+
   static hkClustering &get(std::shared_ptr<networkModel>);
   void clusterWaterWetElements();
   void clusterOilWetElements();
@@ -62,6 +64,23 @@ class hkClustering {
 
   std::shared_ptr<networkModel> network;
   static hkClustering instance;
+  static thread_local hkClustering *active;
+};
+
+// Per-thread clusters while in scope: the elements of networks processed
+// concurrently point to the clusters of their own thread
+class hkClustering::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  hkClustering own;
+  hkClustering *previous;
 };
 
 }  // namespace PNM
@@ -8,7 +8,9 @@
 #include "pnmOperation.h"
 #include "hkClustering.h"
 #include "misc/maths.h"
+#include "misc/parallel.h"
 #include "misc/randomGenerator.h"
+#include "misc/tools.h"
 #include "misc/userInput.h"
 #include "network/cluster.h"
 #include "network/iterator.h"
@@ -18,14 +20,18 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <numeric>
 
 namespace PNM {
 
 pnmOperation pnmOperation::instance;
+thread_local pnmOperation *pnmOperation::active = nullptr;
 
 pnmOperation &pnmOperation::get(std::shared_ptr<networkModel> network) {
-  instance.network = network;
-  return instance;
+  pnmOperation &target = active ? *active : instance;
+  target.network = network;
+  return target;
 }
 
 void pnmOperation::assignRadii() {
@@ -152,47 +158,120 @@ void pnmOperation::assignVolumes() {
 }
 
 void pnmOperation::assignViscosities() {
-  for (element *e : pnmRange<element>(network)) {
-    e->setViscosity(e->getOilFraction() * userInput::get().oilViscosity +
-                    e->getWaterFraction() * userInput::get().waterViscosity);
-  }
+  parallel::forChunks(network->totalNodes, [this](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      node *n = network->getNode(i);
+      n->setViscosity(n->getOilFraction() * userInput::get().oilViscosity +
+                      n->getWaterFraction() * userInput::get().waterViscosity);
+    }
+  });
+
+  parallel::forChunks(network->totalPores, [this](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      pore *p = network->getPore(i);
+      p->setViscosity(p->getOilFraction() * userInput::get().oilViscosity +
+                      p->getWaterFraction() * userInput::get().waterViscosity);
+    }
+  });
 }
 
-void pnmOperation::assignConductivities() {
-  for (node *n : pnmRange<node>(network)) {
-    n->setConductivity(
-        userInput::get().poreConductivityConstant *
-        n->getShapeFactorConstant() *
-        pow(n->getRadius(), userInput::get().poreConductivityExponent) /
-        (16 * n->getShapeFactor()) / (n->getLength() * n->getViscosity()) *
-        pow(10, (6 * userInput::get().poreConductivityExponent - 24)));
-  }
+void pnmOperation::assignConductivityFactors() {
+  auto factor = [](element *e) {
+    return userInput::get().poreConductivityConstant *
+           e->getShapeFactorConstant() *
+           pow(e->getRadius(), userInput::get().poreConductivityExponent) /
+           (16 * e->getShapeFactor()) / e->getLength() *
+           pow(10, (6 * userInput::get().poreConductivityExponent - 24));
+  };
 
-  for (pore *p : pnmRange<pore>(network)) {
-    node *nodeIn = p->getNodeIn();
-    node *nodeOut = p->getNodeOut();
-    auto throatConductivityInverse(0.0), nodeInConductivityInverse(0.0),
-        nodeOutConductivityInverse(0.0);
+  parallel::forChunks(network->totalNodes, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      node *n = network->getNode(i);
+      n->setConductivityFactor(factor(n));
+    }
+  });
 
-    auto throatConductivity =
-        userInput::get().poreConductivityConstant *
-        p->getShapeFactorConstant() *
-        pow(p->getRadius(), userInput::get().poreConductivityExponent) /
-        (16 * p->getShapeFactor()) / (p->getLength() * p->getViscosity()) *
-        pow(10, (6 * userInput::get().poreConductivityExponent - 24));
+  parallel::forChunks(network->totalPores, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      pore *p = network->getPore(i);
+      p->setConductivityFactor(factor(p));
+    }
+  });
+}
 
-    throatConductivityInverse = 1 / throatConductivity;
+namespace {
+double seriesConductivity(pore *p, double throatConductivity) {
+  node *nodeIn = p->getNodeIn();
+  node *nodeOut = p->getNodeOut();
 
-    if (nodeIn != nullptr)
-      nodeInConductivityInverse = 1 / (nodeIn->getConductivity() * 2);
+  double throatConductivityInverse = 1 / throatConductivity;
+  double nodeInConductivityInverse =
+      nodeIn != nullptr ? 1 / (nodeIn->getConductivity() * 2) : 0;
+  double nodeOutConductivityInverse =
+      nodeOut != nullptr ? 1 / (nodeOut->getConductivity() * 2) : 0;
 
-    if (nodeOut != nullptr)
-      nodeOutConductivityInverse = 1 / (nodeOut->getConductivity() * 2);
+  return 1. / (throatConductivityInverse + nodeInConductivityInverse +
+               nodeOutConductivityInverse);
+}
+}  // namespace
 
-    p->setConductivity(1. /
-                       (throatConductivityInverse + nodeInConductivityInverse +
-                        nodeOutConductivityInverse));
-  }
+void pnmOperation::assignConductivities() {
+  // Throat conductivities depend on the conductivities of both nodes: the
+  // nodes are all updated first
+  parallel::forChunks(network->totalNodes, [this](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      node *n = network->getNode(i);
+      n->setConductivity(n->getConductivityFactor() / n->getViscosity());
+    }
+  });
+
+  parallel::forChunks(network->totalPores, [this](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      pore *p = network->getPore(i);
+      p->setConductivity(seriesConductivity(
+          p, p->getConductivityFactor() / p->getViscosity()));
+    }
+  });
+}
+
+void pnmOperation::updateConductivities() {
+  // Same as assignViscosities followed by assignConductivities, for networks
+  // whose conductivities are already consistent with their viscosities: only
+  // the elements whose viscosity changed, and the throats next to a changed
+  // node, are recalculated
+  auto viscosity = [](element *e) {
+    return e->getOilFraction() * userInput::get().oilViscosity +
+           e->getWaterFraction() * userInput::get().waterViscosity;
+  };
+
+  std::vector<char> changedNodes(network->totalNodes, false);
+
+  parallel::forChunks(network->totalNodes, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      node *n = network->getNode(i);
+      double newViscosity = viscosity(n);
+      if (newViscosity == n->getViscosity()) continue;
+      n->setViscosity(newViscosity);
+      n->setConductivity(n->getConductivityFactor() / newViscosity);
+      changedNodes[i] = true;
+    }
+  });
+
+  parallel::forChunks(network->totalPores, [&](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      pore *p = network->getPore(i);
+      node *nodeIn = p->getNodeIn();
+      node *nodeOut = p->getNodeOut();
+      double newViscosity = viscosity(p);
+      if (newViscosity == p->getViscosity() &&
+          (nodeIn == nullptr || !changedNodes[nodeIn->getId() - 1]) &&
+          (nodeOut == nullptr || !changedNodes[nodeOut->getId() - 1]))
+        continue;
+      p->setViscosity(newViscosity);
+      p->setConductivity(
+          seriesConductivity(p, p->getConductivityFactor() / newViscosity));
+    }
+  });
 }
 
 void pnmOperation::calculateNetworkVolume() {
@@ -293,6 +372,10 @@ void pnmOperation::assignFilmsStability() {
 }
 
 void pnmOperation::assignWettabilities() {
+  // Bumped before any branch returns: every assignment invalidates the
+  // threshold tables built on the previous contact angles
+  network->wettabilityRevision++;
+
   randomGenerator gen(userInput::get().seed);
 
   if (userInput::get().wettability == networkWettability::oilWet) {
@@ -301,7 +384,6 @@ void pnmOperation::assignWettabilities() {
                                    userInput::get().maxOilWetTheta));
       e->setWettabilityFlag(wettability::oilWet);
     };
-    pnmOperation::get(network).backupWettability();
     return;
   }
 
@@ -311,10 +393,7 @@ void pnmOperation::assignWettabilities() {
     e->setWettabilityFlag(wettability::waterWet);
   };
 
-  if (userInput::get().wettability == networkWettability::waterWet) {
-    pnmOperation::get(network).backupWettability();
-    return;
-  }
+  if (userInput::get().wettability == networkWettability::waterWet) return;
 
   if (userInput::get().wettability == networkWettability::fracionalWet)  // FW
   {
@@ -413,6 +492,16 @@ void pnmOperation::restoreWettability() {
                               ? wettability::waterWet
                               : wettability::oilWet);
   }
+
+  network->wettabilityRevision++;
+}
+
+void pnmOperation::releaseFilmAttributes() {
+  for (element *e : pnmRange<element>(network)) e->releaseFilmAttributes();
+}
+
+void pnmOperation::releaseTracerAttributes() {
+  for (element *e : pnmRange<element>(network)) e->releaseTracerAttributes();
 }
 
 void pnmOperation::assignWWWettability() {
@@ -420,6 +509,8 @@ void pnmOperation::assignWWWettability() {
     e->setTheta(0);
     e->setWettabilityFlag(wettability::waterWet);
   }
+
+  network->wettabilityRevision++;
 }
 
 void pnmOperation::assignOilConductivities() {
@@ -455,12 +546,7 @@ void pnmOperation::assignOilConductivities() {
 
     if (p->getPhaseFlag() == phase::oil) {
       if (p->getClusterOilConductor()->getSpanning())
-        throatConductivity =
-            userInput::get().poreConductivityConstant *
-            p->getShapeFactorConstant() *
-            pow(p->getRadius(), userInput::get().poreConductivityExponent) /
-            (16 * p->getShapeFactor()) / (p->getLength() * p->getViscosity()) *
-            pow(10, (6 * userInput::get().poreConductivityExponent - 24));
+        throatConductivity = p->getConductivityFactor() / p->getViscosity();
       else {
         p->setActive(false);
         continue;
@@ -522,12 +608,7 @@ void pnmOperation::assignWaterConductivities() {
 
     if (p->getPhaseFlag() == phase::water) {
       if (p->getClusterWaterConductor()->getSpanning())
-        throatConductivity =
-            userInput::get().poreConductivityConstant *
-            p->getShapeFactorConstant() *
-            pow(p->getRadius(), userInput::get().poreConductivityExponent) /
-            (16 * p->getShapeFactor()) / (p->getLength() * p->getViscosity()) *
-            pow(10, (6 * userInput::get().poreConductivityExponent - 24));
+        throatConductivity = p->getConductivityFactor() / p->getViscosity();
       else {
         p->setActive(false);
         continue;
@@ -634,7 +715,7 @@ void pnmOperation::setSwi() {
     auto sim = std::make_shared<primaryDrainage>(
         userInput::get().initialWaterSaturation);
     sim->setNetwork(network);
-    sim->execute();
+    sim->drainToFinalSwi();
   }
 
   std::for_each(pnmRange<pore>(network).begin(), pnmRange<pore>(network).end(),
@@ -664,6 +745,28 @@ void pnmOperation::fillWithWater() {
                 [](element *e) { e->setPhaseFlag(phase::water); });
 }
 
+void pnmOperation::countOilNeighboors() {
+  for (node *n : pnmRange<node>(network)) {
+    int oilNeighboors(0);
+    for (element *e : n->getNeighboors())
+      if (e->getPhaseFlag() == phase::oil) oilNeighboors++;
+    n->setOilNeighboors(oilNeighboors);
+  }
+}
+
+// To be called when a throat changes phase, so that the counts of its nodes
+// do not need to be recomputed
+void pnmOperation::updateOilNeighboors(element *throat, phase previous) {
+  int change = (throat->getPhaseFlag() == phase::oil ? 1 : 0) -
+               (previous == phase::oil ? 1 : 0);
+  if (change == 0) return;
+
+  for (element *e : throat->getNeighboors()) {
+    node *n = static_cast<node *>(e);
+    n->setOilNeighboors(n->getOilNeighboors() + change);
+  }
+}
+
 double pnmOperation::getSw() {
   double waterVolume(0);
   for (element *e : pnmRange<element>(network)) {
@@ -689,6 +792,146 @@ double pnmOperation::getInletPoresVolume() {
   return inletPoresVolume;
 }
 
+void pnmOperation::reorderNetwork() {
+  // Ids always follow the table order, whatever the network source
+  int pid(0);
+  for (pore *p : pnmRange<pore>(network)) p->setId(++pid);
+
+  int nid(0);
+  for (node *n : pnmRange<node>(network)) n->setId(++nid);
+
+  auto ordering = userInput::get().networkOrdering;
+  if (ordering == nodeOrdering::none) return;
+
+  std::cout << "Reordering network..." << std::endl;
+
+  std::vector<int> nodeOrder =
+      ordering == nodeOrdering::reverseCuthillMcKee
+          ? getCuthillMcKeeOrdering()
+          : getSpaceFillingCurveOrdering(ordering == nodeOrdering::hilbert);
+
+  std::vector<int> nodeRank(network->totalNodes);
+  for (int i = 0; i < network->totalNodes; ++i) nodeRank[nodeOrder[i]] = i;
+
+  // Pores follow the nodes they connect, sorted by their lowest node rank
+  auto poreKey = [&nodeRank](pore *p) -> std::pair<int, int> {
+    int in = p->getNodeIn() ? nodeRank[p->getNodeIn()->getId() - 1] : -1;
+    int out = p->getNodeOut() ? nodeRank[p->getNodeOut()->getId() - 1] : -1;
+    if (in == -1) return {out, out};
+    if (out == -1) return {in, in};
+    return {std::min(in, out), std::max(in, out)};
+  };
+
+  std::vector<int> poreOrder(network->totalPores);
+  std::iota(poreOrder.begin(), poreOrder.end(), 0);
+  std::stable_sort(poreOrder.begin(), poreOrder.end(),
+                   [this, &poreKey](int i, int j) {
+                     return poreKey(network->getPore(i)) <
+                            poreKey(network->getPore(j));
+                   });
+
+  std::vector<networkModel::nodePtr> tableOfNodes;
+  tableOfNodes.reserve(network->totalNodes);
+  network->nodeSourceIds.resize(network->totalNodes);
+  for (int i = 0; i < network->totalNodes; ++i) {
+    tableOfNodes.push_back(network->tableOfNodes[nodeOrder[i]]);
+    network->nodeSourceIds[i] = nodeOrder[i] + 1;
+  }
+
+  std::vector<networkModel::porePtr> tableOfPores;
+  tableOfPores.reserve(network->totalPores);
+  network->poreSourceIds.resize(network->totalPores);
+  for (int i = 0; i < network->totalPores; ++i) {
+    tableOfPores.push_back(network->tableOfPores[poreOrder[i]]);
+    network->poreSourceIds[i] = poreOrder[i] + 1;
+  }
+
+  network->tableOfNodes.swap(tableOfNodes);
+  network->tableOfPores.swap(tableOfPores);
+
+  pid = 0;
+  for (pore *p : pnmRange<pore>(network)) p->setId(++pid);
+
+  nid = 0;
+  for (node *n : pnmRange<node>(network)) n->setId(++nid);
+
+  auto byId = [](pore *a, pore *b) { return a->getId() < b->getId(); };
+  std::sort(network->inletPores.begin(), network->inletPores.end(), byId);
+  std::sort(network->outletPores.begin(), network->outletPores.end(), byId);
+}
+
+std::vector<int> pnmOperation::getCuthillMcKeeOrdering() {
+  auto degree = [this](int i) {
+    return network->getNode(i)->getNeighboors().size();
+  };
+
+  // Seeds are taken by increasing degree to start each component from a
+  // peripheral node
+  std::vector<int> seeds(network->totalNodes);
+  std::iota(seeds.begin(), seeds.end(), 0);
+  std::stable_sort(seeds.begin(), seeds.end(),
+                   [&degree](int i, int j) { return degree(i) < degree(j); });
+
+  std::vector<int> order;
+  order.reserve(network->totalNodes);
+  std::vector<bool> visited(network->totalNodes, false);
+
+  for (int seed : seeds) {
+    if (visited[seed]) continue;
+
+    visited[seed] = true;
+    order.push_back(seed);
+
+    for (size_t head = order.size() - 1; head < order.size(); ++head) {
+      node *n = network->getNode(order[head]);
+      size_t first = order.size();
+
+      for (element *e : n->getNeighboors()) {
+        pore *p = static_cast<pore *>(e);
+        node *neighboor =
+            p->getNodeIn() == n ? p->getNodeOut() : p->getNodeIn();
+        if (!neighboor || visited[neighboor->getId() - 1]) continue;
+
+        visited[neighboor->getId() - 1] = true;
+        order.push_back(neighboor->getId() - 1);
+      }
+
+      std::stable_sort(
+          order.begin() + first, order.end(),
+          [&degree](int i, int j) { return degree(i) < degree(j); });
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+std::vector<int> pnmOperation::getSpaceFillingCurveOrdering(bool hilbert) {
+  const double maxCoordinate = (1 << 21) - 1;
+  auto quantise = [maxCoordinate](double coordinate, double edgeLength) {
+    if (edgeLength <= 0) return 0u;
+    double x = std::max(0.0, std::min(1.0, coordinate / edgeLength));
+    return unsigned(x * maxCoordinate);
+  };
+
+  std::vector<unsigned long long> keys;
+  keys.reserve(network->totalNodes);
+  for (node *n : pnmRange<node>(network)) {
+    unsigned x = quantise(n->getXCoordinate(), network->xEdgeLength);
+    unsigned y = quantise(n->getYCoordinate(), network->yEdgeLength);
+    unsigned z = quantise(n->getZCoordinate(), network->zEdgeLength);
+    keys.push_back(hilbert ? maths::hilbertKey(x, y, z)
+                           : maths::mortonKey(x, y, z));
+  }
+
+  std::vector<int> order(network->totalNodes);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&keys](int i, int j) { return keys[i] < keys[j]; });
+
+  return order;
+}
+
 void pnmOperation::exportToNumcalFormat() {
   std::ofstream file;
 
@@ -730,10 +973,26 @@ void pnmOperation::exportToNumcalFormat() {
          << p->getShapeFactor() << std::endl;
   }
   file.close();
+
+  if (network->nodeSourceIds.empty()) return;
+
+  file.open("numSCAL_Networks/_ordering.num");
+  file << "element,id,sourceId" << std::endl;
+
+  for (node *n : pnmRange<node>(network))
+    file << "node," << n->getId() << ","
+         << network->nodeSourceIds[n->getId() - 1] << std::endl;
+
+  for (pore *p : pnmRange<pore>(network))
+    file << "throat," << p->getId() << ","
+         << network->poreSourceIds[p->getId() - 1] << std::endl;
+
+  file.close();
 }
 
 void pnmOperation::generateNetworkState(int frame, std::string folderPath) {
-  std::string path = "Network_State/" + folderPath + "/network_state_" +
+  std::string path = tools::outputPath("Network_State/" + folderPath) +
+                     "/network_state_" +
                      boost::str(boost::format("%07d") % frame) + ".nums";
 
   std::ofstream file;
@@ -9,14 +9,18 @@
 #define PNMOPERATION_H
 
 #include <memory>
+#include <vector>
 
 namespace PNM {
 
 class networkModel;
+class element;
 enum class phase;
 
 class pnmOperation {
  public:
+  class scope;
+
   static pnmOperation &get(std::shared_ptr<networkModel>);
   void assignRadii();
   void assignLengths();
@@ -25,21 +29,28 @@ class pnmOperation {
   void assignShapeFactorConstants();
   void assignVolumes();
   void assignViscosities();
+  void assignConductivityFactors();
   void assignConductivities();
+  void updateConductivities();
   void calculateNetworkVolume();
   void assignHalfAngles();
   void assignFilmsStability();
   void assignWettabilities();
   void backupWettability();
   void restoreWettability();
+  void releaseFilmAttributes();
+  void releaseTracerAttributes();
   void assignWWWettability();
   void assignOilConductivities();
   void assignWaterConductivities();
   void setSwi();
   void fillWithWater();
+  void countOilNeighboors();
+  void updateOilNeighboors(element *throat, phase previous);
   double getSw();
   double getFlow(phase);
   double getInletPoresVolume();
+  void reorderNetwork();
   void exportToNumcalFormat();
   void generateNetworkState(int frame, std::string folderPath = "");
 
@@ -49,9 +60,27 @@ class pnmOperation {
   pnmOperation(pnmOperation &&) = delete;
   auto operator=(const pnmOperation &) -> pnmOperation & = delete;
   auto operator=(pnmOperation &&) -> pnmOperation & = delete;
+  std::vector<int> getCuthillMcKeeOrdering();
+  std::vector<int> getSpaceFillingCurveOrdering(bool);
 
   std::shared_ptr<networkModel> network;
   static pnmOperation instance;
+  static thread_local pnmOperation *active;
+};
+
+// Per-thread instance while in scope (see userInput::scope)
+class pnmOperation::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  pnmOperation own;
+  pnmOperation *previous;
 };
 
 }  // namespace PNM
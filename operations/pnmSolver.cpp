@@ -6,7 +6,9 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "pnmSolver.h"
+#include "misc/memoryReport.h"
 #include "misc/userInput.h"
+#include "network/cluster.h"
 #include "network/iterator.h"
 #include "operations/hkClustering.h"
 #include "operations/pnmOperation.h"
@@ -14,6 +16,7 @@
 // Eigen library
 #include <fstream>
 #include <iostream>
+#include <libs/Eigen/Dense>
 #include <libs/Eigen/IterativeLinearSolvers>
 #include <libs/Eigen/Sparse>
 #include <libs/Eigen/SparseCholesky>
@@ -24,28 +27,43 @@ using namespace Eigen;
 using namespace std;
 
 pnmSolver pnmSolver::instance;
+thread_local pnmSolver *pnmSolver::active = nullptr;
+
+namespace {
+void recordMatrixMemory(const SparseMatrix<double> &matrix) {
+  memoryReport::get().record(
+      "Solver matrices",
+      matrix.nonZeros() * (sizeof(double) + sizeof(int)) +
+          (matrix.outerSize() + 1) * sizeof(int) +
+          2 * matrix.rows() * sizeof(double));  // right hand side + solution
+}
 
-pnmSolver &pnmSolver::get(std::shared_ptr<networkModel> network) {
-  instance.network = network;
-  return instance;
+void recordFactorizationMemory(
+    const SimplicialLDLT<SparseMatrix<double>> &solver, int size) {
+  std::size_t factorNonZeros = solver.matrixL().nestedExpression().nonZeros();
+  memoryReport::get().record(
+      "Factorization", factorNonZeros * (sizeof(double) + sizeof(int)) +
+                           size * (sizeof(double) + 3 * sizeof(int)));
 }
 
-double pnmSolver::solvePressuresConstantGradient(double pressureIn,
-                                                 double pressureOut,
-                                                 bool defaultSolver) {
-  if (network->totalNodes == 0)
-    throw std::range_error("Empty network can't be solved");
+void recordIterativeSolverMemory(int size) {
+  // Diagonal preconditioner and the four work vectors of conjugate gradient
+  memoryReport::get().record("Factorization", 5 * size * sizeof(double));
+}
 
-  SparseMatrix<double> conductivityMatrix(network->totalNodes,
-                                          network->totalNodes);
+void assembleConstantFlowRateSystem(std::shared_ptr<networkModel> network,
+                                    SparseMatrix<double> &conductivityMatrix,
+                                    VectorXd &b) {
+  conductivityMatrix.resize(network->totalNodes, network->totalNodes);
   conductivityMatrix.reserve(VectorXi::Constant(
       network->totalNodes, network->maxConnectionNumber + 3));
-  VectorXd b = VectorXd::Zero(network->totalNodes);
-  VectorXd pressures = VectorXd::Zero(network->totalNodes);
+  b = VectorXd::Zero(network->totalNodes);
 
   auto rank(0);
   for (node *n : pnmRange<node>(network)) n->setRank(rank++);
 
+  double inletPoresVolume = pnmOperation::get(network).getInletPoresVolume();
+
   int row = 0;
   for (node *n : pnmRange<node>(network)) {
     double conductivity(1e-200);
@@ -53,11 +71,10 @@ double pnmSolver::solvePressuresConstantGradient(double pressureIn,
       pore *p = static_cast<pore *>(e);
       if (p->getActive()) {
         if (p->getInlet()) {
-          b(row) = -pressureIn * p->getConductivity();
-          conductivity -= p->getConductivity();
+          b(row) -=
+              p->getVolume() / inletPoresVolume * userInput::get().flowRate;
         }
         if (p->getOutlet()) {
-          b(row) = -pressureOut * p->getConductivity();
           conductivity -= p->getConductivity();
         }
         if (!p->getInlet() && !p->getOutlet()) {
@@ -78,44 +95,20 @@ double pnmSolver::solvePressuresConstantGradient(double pressureIn,
     row++;
   }
   conductivityMatrix.makeCompressed();
-
-  if (defaultSolver ||
-      userInput::get().solverChoice == solver::conjugateGradient) {
-    ConjugateGradient<SparseMatrix<double>, Lower | Upper> solver;
-    solver.setTolerance(1e-25);
-    solver.setMaxIterations(2000);
-    solver.compute(conductivityMatrix);
-    pressures = solver.solve(b);
-  }
-
-  else if (userInput::get().solverChoice == solver::cholesky) {
-    SimplicialLDLT<SparseMatrix<double>> solver;
-    solver.compute(conductivityMatrix);
-    pressures = solver.solve(b);
-  }
-
-  for (node *n : pnmRange<node>(network))
-    n->setPressure(pressures[n->getRank()]);
-
-  return updateFlowsConstantGradient(pressureIn, pressureOut);
+  recordMatrixMemory(conductivityMatrix);
 }
-
-double pnmSolver::solvePressuresConstantFlowRate() {
-  if (network->totalNodes == 0)
-    throw std::range_error("Empty network can't be solved");
-
-  SparseMatrix<double> conductivityMatrix(network->totalNodes,
-                                          network->totalNodes);
+void assembleConstantGradientSystem(std::shared_ptr<networkModel> network,
+                                    double pressureIn, double pressureOut,
+                                    SparseMatrix<double> &conductivityMatrix,
+                                    VectorXd &b) {
+  conductivityMatrix.resize(network->totalNodes, network->totalNodes);
   conductivityMatrix.reserve(VectorXi::Constant(
       network->totalNodes, network->maxConnectionNumber + 3));
-  VectorXd b = VectorXd::Zero(network->totalNodes);
-  VectorXd pressures = VectorXd::Zero(network->totalNodes);
+  b = VectorXd::Zero(network->totalNodes);
 
   auto rank(0);
   for (node *n : pnmRange<node>(network)) n->setRank(rank++);
 
-  double inletPoresVolume = pnmOperation::get(network).getInletPoresVolume();
-
   int row = 0;
   for (node *n : pnmRange<node>(network)) {
     double conductivity(1e-200);
@@ -123,10 +116,11 @@ double pnmSolver::solvePressuresConstantFlowRate() {
       pore *p = static_cast<pore *>(e);
       if (p->getActive()) {
         if (p->getInlet()) {
-          b(row) -=
-              p->getVolume() / inletPoresVolume * userInput::get().flowRate;
+          b(row) = -pressureIn * p->getConductivity();
+          conductivity -= p->getConductivity();
         }
         if (p->getOutlet()) {
+          b(row) = -pressureOut * p->getConductivity();
           conductivity -= p->getConductivity();
         }
         if (!p->getInlet() && !p->getOutlet()) {
@@ -147,6 +141,182 @@ double pnmSolver::solvePressuresConstantFlowRate() {
     row++;
   }
   conductivityMatrix.makeCompressed();
+  recordMatrixMemory(conductivityMatrix);
+}
+
+// Whether closing a throat may have cut active throats off from the inlet or
+// the outlet. Before the closure, all the active throats belonged to spanning
+// clusters: they stay so if the two ends of the closed throat are still
+// connected, or if the node of a closed inlet (outlet) throat still reaches
+// another one. Searched breadth-first from the ends of the closed throat
+// only, over the active elements as clustered (both ends at once for
+// internal throats, so that the search stops at the first loop around the
+// throat). An inactive end is not an issue, nor is an end left without any
+// active throat, as long as the other end still spans the network. Nodes
+// found spanning are remembered until the active throats change (next
+// round).
+class isolationCheck {
+ public:
+  explicit isolationCheck(int totalNodes)
+      : marks(totalNodes, 0), spanningMarks(totalNodes, -1) {}
+
+  void startRound() { ++round; }
+
+  bool cutsOff(pore *p) {
+    node *nodeIn = p->getNodeIn();
+    node *nodeOut = p->getNodeOut();
+    if (p->getInlet() || p->getOutlet()) {
+      node *activeNode = nodeIn == nullptr ? nodeOut : nodeIn;
+      return activeNode->getActive() &&
+             !reaches(activeNode, p->getInlet(), p->getOutlet());
+    }
+
+    if (!nodeIn->getActive() || !nodeOut->getActive()) return false;
+
+    node *ends[2] = {nodeIn, nodeOut};
+    bool separatedThroats;
+    int separated = separatedEnd(ends, separatedThroats);
+    if (separated == -1) return false;
+    return separatedThroats || !reaches(ends[1 - separated], true, true);
+  }
+
+  long long getVisitedNodes() const { return visitedNodes; }
+
+ private:
+  // Whether the active elements connected to start hold an inlet and / or an
+  // outlet throat as requested (true if they hold no throat at all)
+  bool reaches(node *start, bool inlet, bool outlet) {
+    stamp += 2;
+    std::vector<node *> queue{start};
+    marks[start->getRank()] = stamp;
+    bool spanningSearch = inlet && outlet;
+    bool foundThroats = false;
+    for (size_t i = 0; i < queue.size(); ++i) {
+      ++visitedNodes;
+      if (spanningMarks[queue[i]->getRank()] == round) return true;
+      for (element *e : queue[i]->getNeighboors()) {
+        pore *p = static_cast<pore *>(e);
+        if (!p->getActive()) continue;
+        foundThroats = true;
+        if (p->getInlet()) inlet = false;
+        if (p->getOutlet()) outlet = false;
+        if (!inlet && !outlet) {
+          if (spanningSearch)
+            for (node *n : queue) spanningMarks[n->getRank()] = round;
+          return true;
+        }
+        if (p->getInlet() || p->getOutlet()) continue;
+        node *next = p->getOtherNode(queue[i]);
+        if (next->getActive() && marks[next->getRank()] != stamp) {
+          marks[next->getRank()] = stamp;
+          queue.push_back(next);
+        }
+      }
+    }
+    return !foundThroats;
+  }
+
+  // Searches from both ends at once (the second end's side marked stamp + 1):
+  // -1 if they are connected, otherwise the end whose side was searched
+  // through (separatedThroats telling whether it holds any active throat)
+  int separatedEnd(node *ends[2], bool &separatedThroats) {
+    stamp += 2;
+    std::vector<node *> queues[2] = {{ends[0]}, {ends[1]}};
+    size_t heads[2] = {0, 0};
+    bool foundThroats[2] = {false, false};
+    marks[ends[0]->getRank()] = stamp;
+    marks[ends[1]->getRank()] = stamp + 1;
+    for (int side = 0;; side = 1 - side) {
+      if (heads[side] == queues[side].size()) {
+        separatedThroats = foundThroats[side];
+        return side;
+      }
+      node *n = queues[side][heads[side]++];
+      ++visitedNodes;
+      for (element *e : n->getNeighboors()) {
+        pore *p = static_cast<pore *>(e);
+        if (!p->getActive()) continue;
+        foundThroats[side] = true;
+        if (p->getInlet() || p->getOutlet()) continue;
+        node *next = p->getOtherNode(n);
+        if (!next->getActive()) continue;
+        int &mark = marks[next->getRank()];
+        if (mark == stamp + 1 - side) return -1;
+        if (mark != stamp + side) {
+          mark = stamp + side;
+          queues[side].push_back(next);
+        }
+      }
+    }
+  }
+
+  std::vector<int> marks;          // stamp of the last search, by rank
+  std::vector<int> spanningMarks;  // round in which found spanning, by rank
+  int stamp = 0;
+  int round = 0;
+  long long visitedNodes = 0;
+};
+
+// Thread safe: does not touch the network nor the user input
+VectorXd solveSystem(const SparseMatrix<double> &conductivityMatrix,
+                     const VectorXd &b, bool conjugateGradient) {
+  VectorXd pressures = VectorXd::Zero(conductivityMatrix.rows());
+
+  if (conjugateGradient) {
+    ConjugateGradient<SparseMatrix<double>, Lower | Upper> solver;
+    solver.setTolerance(1e-25);
+    solver.setMaxIterations(2000);
+    solver.compute(conductivityMatrix);
+    pressures = solver.solve(b);
+    recordIterativeSolverMemory(conductivityMatrix.rows());
+  }
+
+  else {
+    SimplicialLDLT<SparseMatrix<double>> solver;
+    solver.compute(conductivityMatrix);
+    pressures = solver.solve(b);
+    recordFactorizationMemory(solver, conductivityMatrix.rows());
+  }
+
+  return pressures;
+}
+}  // namespace
+
+pnmSolver &pnmSolver::get(std::shared_ptr<networkModel> network) {
+  pnmSolver &target = active ? *active : instance;
+  target.network = network;
+  return target;
+}
+
+double pnmSolver::solvePressuresConstantGradient(double pressureIn,
+                                                 double pressureOut,
+                                                 bool defaultSolver) {
+  if (network->totalNodes == 0)
+    throw std::range_error("Empty network can't be solved");
+
+  SparseMatrix<double> conductivityMatrix;
+  VectorXd b;
+  assembleConstantGradientSystem(network, pressureIn, pressureOut,
+                                 conductivityMatrix, b);
+  VectorXd pressures = solveSystem(
+      conductivityMatrix, b,
+      defaultSolver ||
+          userInput::get().solverChoice == solver::conjugateGradient);
+
+  for (node *n : pnmRange<node>(network))
+    n->setPressure(pressures[n->getRank()]);
+
+  return updateFlowsConstantGradient(pressureIn, pressureOut);
+}
+
+double pnmSolver::solvePressuresConstantFlowRate() {
+  if (network->totalNodes == 0)
+    throw std::range_error("Empty network can't be solved");
+
+  SparseMatrix<double> conductivityMatrix;
+  VectorXd b;
+  VectorXd pressures = VectorXd::Zero(network->totalNodes);
+  assembleConstantFlowRateSystem(network, conductivityMatrix, b);
 
   if (userInput::get().solverChoice == solver::conjugateGradient) {
     ConjugateGradient<SparseMatrix<double>, Lower | Upper> solver;
@@ -154,12 +324,14 @@ double pnmSolver::solvePressuresConstantFlowRate() {
     solver.setMaxIterations(2000);
     solver.compute(conductivityMatrix);
     pressures = solver.solve(b);
+    recordIterativeSolverMemory(network->totalNodes);
   }
 
   else if (userInput::get().solverChoice == solver::cholesky) {
     SimplicialLDLT<SparseMatrix<double>> solver;
     solver.compute(conductivityMatrix);
     pressures = solver.solve(b);
+    recordFactorizationMemory(solver, network->totalNodes);
   }
 
   for (node *n : pnmRange<node>(network))
@@ -168,6 +340,178 @@ double pnmSolver::solvePressuresConstantFlowRate() {
   return updateFlowsConstantFlowRate();
 }
 
+double pnmSolver::solvePressuresConstantFlowRate(
+    const std::function<bool(pore *)> &mustClose) {
+  if (network->totalNodes == 0)
+    throw std::range_error("Empty network can't be solved");
+
+  outerPasses = 0;
+  activeSetPasses = 0;
+  isolationFallbacks = 0;
+
+  // Throats closed after the factorization are accounted for as low-rank
+  // updates of the factorized matrix (Woodbury identity): closing a throat
+  // of conductivity g between nodes i and j adds g * u * u^T to the matrix,
+  // with u = e_i - e_j (u = e_i for an outlet throat)
+  const size_t maxLowRankUpdates = 64;
+  bool reuseFactorization =
+      userInput::get().solverChoice == solver::cholesky;
+
+  double outletFlow(0);
+  bool converged = false;
+  isolationCheck isolation(network->totalNodes);
+
+  while (!converged) {
+    ++outerPasses;
+
+    hkClustering::get(network).clusterActiveElements();
+    for (pore *p : pnmRange<pore>(network)) {
+      if (p->getActive() && !p->getClusterActive()->getSpanning()) {
+        p->setCapillaryPressure(0);
+        p->setActive(false);
+      }
+    }
+
+    SparseMatrix<double> conductivityMatrix;
+    VectorXd b;
+    assembleConstantFlowRateSystem(network, conductivityMatrix, b);
+
+    // Injection part of the right hand side, kept apart from b: the flow rate
+    // is shared between the active inlet throats by volume, so closing one
+    // rescales the share of the others
+    double inletPoresVolume =
+        pnmOperation::get(network).getInletPoresVolume();
+    VectorXd injection = VectorXd::Zero(network->totalNodes);
+    for (pore *p : pnmInlet(network)) {
+      if (p->getActive()) {
+        node *activeNode =
+            p->getNodeIn() == nullptr ? p->getNodeOut() : p->getNodeIn();
+        injection(activeNode->getRank()) -=
+            p->getVolume() / inletPoresVolume * userInput::get().flowRate;
+      }
+    }
+    b -= injection;
+
+    SimplicialLDLT<SparseMatrix<double>> cholesky;
+    ConjugateGradient<SparseMatrix<double>, Lower | Upper> conjugateGradient;
+    if (reuseFactorization) {
+      cholesky.compute(conductivityMatrix);
+      recordFactorizationMemory(cholesky, network->totalNodes);
+    } else {
+      conjugateGradient.setTolerance(1e-25);
+      conjugateGradient.setMaxIterations(2000);
+      conjugateGradient.compute(conductivityMatrix);
+      recordIterativeSolverMemory(network->totalNodes);
+    }
+    auto solve = [&](const VectorXd &rhs) -> VectorXd {
+      if (reuseFactorization) return cholesky.solve(rhs);
+      return conjugateGradient.solve(rhs);
+    };
+
+    std::vector<std::pair<int, int>> updateNodes;
+    std::vector<double> updateConductivities;
+    std::vector<VectorXd> updateSolutions;
+    auto applyUpdate = [](const std::pair<int, int> &nodes,
+                          const VectorXd &v) {
+      return v(nodes.first) - (nodes.second == -1 ? 0 : v(nodes.second));
+    };
+
+    while (true) {
+      VectorXd pressures = solve(b + injection);
+
+      if (!updateNodes.empty()) {
+        int size = updateNodes.size();
+        MatrixXd capacitance(size, size);
+        VectorXd projection(size);
+        for (int i = 0; i < size; ++i) {
+          projection(i) = applyUpdate(updateNodes[i], pressures);
+          for (int j = 0; j < size; ++j)
+            capacitance(i, j) = applyUpdate(updateNodes[i], updateSolutions[j]);
+          capacitance(i, i) += 1 / updateConductivities[i];
+        }
+        VectorXd correction = capacitance.fullPivLu().solve(projection);
+        for (int i = 0; i < size; ++i)
+          pressures -= correction(i) * updateSolutions[i];
+      }
+
+      for (node *n : pnmRange<node>(network))
+        n->setPressure(pressures[n->getRank()]);
+      outletFlow = updateFlowsConstantFlowRate();
+
+      std::vector<pore *> closingPores;
+      for (pore *p : pnmRange<pore>(network))
+        if (p->getActive() && mustClose(p)) closingPores.push_back(p);
+
+      if (closingPores.empty()) {
+        converged = true;
+        break;
+      }
+
+      ++activeSetPasses;
+
+      double closedInletVolume(0);
+      for (pore *p : closingPores) {
+        node *nodeIn = p->getNodeIn();
+        node *nodeOut = p->getNodeOut();
+        double conductivity = p->getConductivity();
+
+        if (!p->getInlet() && !p->getOutlet()) {
+          b(nodeIn->getRank()) -= p->getCapillaryPressure() * conductivity;
+          b(nodeOut->getRank()) += p->getCapillaryPressure() * conductivity;
+          updateNodes.push_back({nodeIn->getRank(), nodeOut->getRank()});
+          updateConductivities.push_back(conductivity);
+        } else if (p->getOutlet()) {
+          node *activeNode = nodeIn == nullptr ? nodeOut : nodeIn;
+          updateNodes.push_back({activeNode->getRank(), -1});
+          updateConductivities.push_back(conductivity);
+        } else {
+          node *activeNode = nodeIn == nullptr ? nodeOut : nodeIn;
+          injection(activeNode->getRank()) +=
+              p->getVolume() / inletPoresVolume * userInput::get().flowRate;
+          closedInletVolume += p->getVolume();
+        }
+
+        p->setCapillaryPressure(0);
+        p->setActive(false);
+      }
+
+      if (closedInletVolume > 0) {
+        if (closedInletVolume < inletPoresVolume)
+          injection *=
+              inletPoresVolume / (inletPoresVolume - closedInletVolume);
+        inletPoresVolume -= closedInletVolume;
+      }
+
+      // Closing throats may isolate parts of the network, which makes the
+      // updated system singular: start a new pass with a fresh factorization
+      if (!reuseFactorization || updateNodes.size() > maxLowRankUpdates)
+        break;
+
+      bool isolatedElements = false;
+      isolation.startRound();
+      for (pore *p : closingPores)
+        if (isolation.cutsOff(p)) {
+          isolatedElements = true;
+          break;
+        }
+      if (isolatedElements) {
+        ++isolationFallbacks;
+        break;
+      }
+
+      for (size_t i = updateSolutions.size(); i < updateNodes.size(); ++i) {
+        VectorXd u = VectorXd::Zero(network->totalNodes);
+        u(updateNodes[i].first) = 1;
+        if (updateNodes[i].second != -1) u(updateNodes[i].second) = -1;
+        updateSolutions.push_back(solve(u));
+      }
+    }
+  }
+
+  isolationVisits = isolation.getVisitedNodes();
+  return outletFlow;
+}
+
 double pnmSolver::updateFlowsConstantGradient(double pressureIn,
                                               double pressureOut) {
   double outletFlow(0);
@@ -307,6 +651,100 @@ std::pair<double, double> pnmSolver::calculateRelativePermeabilities() {
   return std::make_pair(oilRelativePermeability, waterRelativePermeability);
 }
 
+pnmSolver::pressureSystem pnmSolver::capturePressureSystem(double pressureIn,
+                                                           double pressureOut) {
+  if (network->totalNodes == 0)
+    throw std::range_error("Empty network can't be solved");
+
+  SparseMatrix<double> conductivityMatrix;
+  VectorXd b;
+  assembleConstantGradientSystem(network, pressureIn, pressureOut,
+                                 conductivityMatrix, b);
+
+  pressureSystem system;
+  system.size = network->totalNodes;
+  system.outerIndices.assign(
+      conductivityMatrix.outerIndexPtr(),
+      conductivityMatrix.outerIndexPtr() + conductivityMatrix.outerSize() + 1);
+  system.innerIndices.assign(
+      conductivityMatrix.innerIndexPtr(),
+      conductivityMatrix.innerIndexPtr() + conductivityMatrix.nonZeros());
+  system.values.assign(
+      conductivityMatrix.valuePtr(),
+      conductivityMatrix.valuePtr() + conductivityMatrix.nonZeros());
+  system.rhs.assign(b.data(), b.data() + b.size());
+  system.pressureOut = pressureOut;
+  system.conjugateGradient =
+      userInput::get().solverChoice == solver::conjugateGradient;
+
+  // Same summation order as updateFlowsConstantGradient
+  for (pore *p : pnmRange<pore>(network)) {
+    if (!p->getActive() || !p->getOutlet()) continue;
+    node *activeNode =
+        p->getNodeIn() == nullptr ? p->getNodeOut() : p->getNodeIn();
+    system.outletRanks.push_back(activeNode->getRank());
+    system.outletConductivities.push_back(p->getConductivity());
+  }
+
+  return system;
+}
+
+double pnmSolver::solveOutletFlow(const pressureSystem &system) {
+  SparseMatrix<double> conductivityMatrix =
+      Map<const SparseMatrix<double>>(
+          system.size, system.size, int(system.values.size()),
+          system.outerIndices.data(), system.innerIndices.data(),
+          system.values.data());
+  VectorXd b = Map<const VectorXd>(system.rhs.data(), system.size);
+  VectorXd pressures =
+      solveSystem(conductivityMatrix, b, system.conjugateGradient);
+
+  double outletFlow(0);
+  for (size_t i = 0; i < system.outletRanks.size(); ++i)
+    outletFlow += (pressures[system.outletRanks[i]] - system.pressureOut) *
+                  system.outletConductivities[i];
+  return outletFlow;
+}
+
+// Same network operations as calculateRelativePermeabilities, without the
+// solves
+pnmSolver::relativePermeabilitySystems
+pnmSolver::captureRelativePermeabilities() {
+  relativePermeabilitySystems systems;
+  pnmOperation::get(network).assignViscosities();
+
+  hkClustering::get(network).clusterOilConductorElements();
+  systems.oilSpanning = hkClustering::get(network).isOilSpanningThroughFilms;
+  if (systems.oilSpanning) {
+    pnmOperation::get(network).assignOilConductivities();
+    systems.oil = capturePressureSystem();
+    systems.oilFactor = userInput::get().oilViscosity / network->normalisedFlow;
+  }
+
+  hkClustering::get(network).clusterWaterConductorElements();
+  systems.waterSpanning =
+      hkClustering::get(network).isWaterSpanningThroughFilms;
+  if (systems.waterSpanning) {
+    pnmOperation::get(network).assignWaterConductivities();
+    systems.water = capturePressureSystem();
+    systems.waterFactor =
+        userInput::get().waterViscosity / network->normalisedFlow;
+  }
+
+  return systems;
+}
+
+std::pair<double, double> pnmSolver::solveRelativePermeabilities(
+    const relativePermeabilitySystems &systems) {
+  double oilRelativePermeability(0), waterRelativePermeability(0);
+  if (systems.oilSpanning)
+    oilRelativePermeability = solveOutletFlow(systems.oil) * systems.oilFactor;
+  if (systems.waterSpanning)
+    waterRelativePermeability =
+        solveOutletFlow(systems.water) * systems.waterFactor;
+  return std::make_pair(oilRelativePermeability, waterRelativePermeability);
+}
+
 pnmSolver::pnmSolver() {}
 
 }  // namespace PNM
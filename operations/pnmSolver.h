@@ -8,25 +8,67 @@
 #ifndef PNMSOLVER_H
 #define PNMSOLVER_H
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace PNM {
 
 class networkModel;
+class pore;
 
 class pnmSolver {
  public:
+  class scope;
+
+  // Constant gradient pressure system detached from the network (compressed
+  // column storage), which can be solved on any thread while the network
+  // keeps changing
+  struct pressureSystem {
+    int size = 0;
+    std::vector<int> outerIndices;
+    std::vector<int> innerIndices;
+    std::vector<double> values;
+    std::vector<double> rhs;
+    std::vector<int> outletRanks;  // node of each active outlet throat
+    std::vector<double> outletConductivities;
+    double pressureOut = 0;
+    bool conjugateGradient = false;  // solver chosen when captured
+  };
+
+  // Relative permeabilities are outletFlow * factor; a phase that does not
+  // span the network has no system and a zero relative permeability
+  struct relativePermeabilitySystems {
+    bool oilSpanning = false;
+    bool waterSpanning = false;
+    pressureSystem oil;
+    pressureSystem water;
+    double oilFactor = 0;
+    double waterFactor = 0;
+  };
+
   static pnmSolver &get(std::shared_ptr<networkModel>);
   double solvePressuresConstantGradient(double pressureIn = 1,
                                         double pressureOut = 0,
                                         bool defaultSolver = false);
   double solvePressuresConstantFlowRate();
+  double solvePressuresConstantFlowRate(const std::function<bool(pore *)> &);
   double updateFlowsConstantGradient(double pressureIn = 1,
                                      double pressureOut = 0);
   double updateFlowsConstantFlowRate();
   double getDeltaP();
   void calculatePermeabilityAndPorosity();
   std::pair<double, double> calculateRelativePermeabilities();
+  pressureSystem capturePressureSystem(double pressureIn = 1,
+                                       double pressureOut = 0);
+  relativePermeabilitySystems captureRelativePermeabilities();
+  static double solveOutletFlow(const pressureSystem &);
+  static std::pair<double, double> solveRelativePermeabilities(
+      const relativePermeabilitySystems &);
+  int getOuterPasses() const { return outerPasses; }
+  int getActiveSetPasses() const { return activeSetPasses; }
+  int getIsolationFallbacks() const { return isolationFallbacks; }
+  long long getIsolationVisits() const { return isolationVisits; }
 
  protected:
   pnmSolver();
@@ -36,7 +78,28 @@ class pnmSolver {
   auto operator=(pnmSolver &&) -> pnmSolver & = delete;
 
   std::shared_ptr<networkModel> network;
+  int outerPasses;      // factorizations in the last constrained solve
+  int activeSetPasses;  // throat closing rounds in the last constrained solve
+
+  int isolationFallbacks;     // refactorizations due to isolated throats
+  long long isolationVisits;  // nodes searched by the isolation checks
   static pnmSolver instance;
+  static thread_local pnmSolver *active;
+};
+
+// Per-thread solver state while in scope (see userInput::scope)
+class pnmSolver::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  pnmSolver own;
+  pnmSolver *previous;
 };
 
 }  // namespace PNM
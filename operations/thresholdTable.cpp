@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "thresholdTable.h"
+#include "misc/userInput.h"
+#include "network/iterator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace PNM {
+
+namespace {
+// Plain loops over contiguous storage, which compilers vectorise
+thresholdTable::pressureRange getRange(const std::vector<double> &values) {
+  double minValue(1e20), maxValue(-1e20);
+  for (double value : values) {
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+  }
+  return {minValue, maxValue};
+}
+
+thresholdTable::pressureRange getAbsoluteRange(
+    const std::vector<double> &values) {
+  double minValue(1e20), maxValue(-1e20);
+  for (double value : values) {
+    minValue = std::min(minValue, std::abs(value));
+    maxValue = std::max(maxValue, std::abs(value));
+  }
+  return {minValue, maxValue};
+}
+}  // namespace
+
+thresholdTable thresholdTable::instance;
+thread_local thresholdTable *thresholdTable::active = nullptr;
+
+thresholdTable &thresholdTable::get(std::shared_ptr<networkModel> network) {
+  thresholdTable &target = active ? *active : instance;
+  target.network = network;
+  if (!target.isValid()) target.build();
+  return target;
+}
+
+// Pore bodies only: 0 means no invaded neighbour, in which case the body can
+// not be filled cooperatively
+double thresholdTable::getBodyFillingPressure(element *e,
+                                              int invadedNeighboors) const {
+  return bodyFilling[(e->getId() - 1) * bodyFillingStride + invadedNeighboors];
+}
+
+thresholdTable::pressureRange thresholdTable::getEntryPressureRange(
+    bool absolute) const {
+  return absolute ? absoluteEntryRange : entryRange;
+}
+
+thresholdTable::pressureRange thresholdTable::getSnapOffPressureRange(
+    bool absolute) const {
+  return absolute ? absoluteSnapOffRange : snapOffRange;
+}
+
+bool thresholdTable::isValid() const {
+  return builtFor == network.get() &&
+         builtRevision == network->wettabilityRevision &&
+         builtTension == userInput::get().OWSurfaceTension &&
+         entry.size() == size_t(network->totalNodes + network->totalPores);
+}
+
+void thresholdTable::build() {
+  int size = network->totalNodes + network->totalPores;
+  double tension = userInput::get().OWSurfaceTension;
+
+  entry.resize(size);
+  snapOff.resize(size);
+  for (element *e : pnmRange<element>(network)) {
+    int i = index(e);
+    entry[i] = e->getEntryPressureCoefficient() * tension *
+               std::cos(e->getTheta()) / e->getRadius();
+    snapOff[i] = tension * std::cos(e->getTheta()) / e->getRadius();
+  }
+
+  bodyFillingStride = 1;
+  for (node *n : pnmRange<node>(network))
+    bodyFillingStride =
+        std::max(bodyFillingStride, int(n->getNeighboors().size()) + 1);
+
+  bodyFilling.assign(size_t(network->totalNodes) * bodyFillingStride, 0);
+  for (node *n : pnmRange<node>(network)) {
+    double *row = &bodyFilling[(n->getId() - 1) * bodyFillingStride];
+    for (int k = 1; k < bodyFillingStride; ++k)
+      row[k] = entry[index(n)] / double(k);
+  }
+
+  entryRange = getRange(entry);
+  absoluteEntryRange = getAbsoluteRange(entry);
+  snapOffRange = getRange(snapOff);
+  absoluteSnapOffRange = getAbsoluteRange(snapOff);
+
+  builtFor = network.get();
+  builtRevision = network->wettabilityRevision;
+  builtTension = tension;
+}
+
+int thresholdTable::index(element *e) const {
+  return e->getType() == capillaryType::throat
+             ? network->totalNodes + e->getId() - 1
+             : e->getId() - 1;
+}
+
+}  // namespace PNM
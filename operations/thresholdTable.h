@@ -0,0 +1,84 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef THRESHOLDTABLE_H
+#define THRESHOLDTABLE_H
+
+#include <memory>
+#include <vector>
+
+namespace PNM {
+
+class networkModel;
+class element;
+
+// Capillary pressure thresholds of every element, computed from the current
+// contact angles and interfacial tension:
+//  - piston-like entry pressure: coefficient * IFT * cos(theta) / radius
+//  - snap-off pressure: IFT * cos(theta) / radius
+//  - pore-body filling pressure for each number of invaded neighbours
+// The table is rebuilt by get() only when the wettability revision of the
+// network or the interfacial tension changed since the last build.
+class thresholdTable {
+ public:
+  class scope;
+
+  struct pressureRange {
+    double min;
+    double max;
+  };
+
+  static thresholdTable &get(std::shared_ptr<networkModel>);
+  double getEntryPressure(element *e) const { return entry[index(e)]; }
+  double getSnapOffPressure(element *e) const { return snapOff[index(e)]; }
+  double getBodyFillingPressure(element *, int invadedNeighboors) const;
+  pressureRange getEntryPressureRange(bool absolute = false) const;
+  pressureRange getSnapOffPressureRange(bool absolute = false) const;
+
+ protected:
+  thresholdTable() {}
+  thresholdTable(const thresholdTable &) = delete;
+  thresholdTable(thresholdTable &&) = delete;
+  auto operator=(const thresholdTable &) -> thresholdTable & = delete;
+  auto operator=(thresholdTable &&) -> thresholdTable & = delete;
+  bool isValid() const;
+  void build();
+  int index(element *) const;
+
+  std::shared_ptr<networkModel> network;
+  std::vector<double> entry;
+  std::vector<double> snapOff;
+  std::vector<double> bodyFilling;  // one row of bodyFillingStride per node
+  int bodyFillingStride = 0;
+  pressureRange entryRange, absoluteEntryRange;
+  pressureRange snapOffRange, absoluteSnapOffRange;
+  networkModel *builtFor = nullptr;
+  unsigned builtRevision = 0;
+  double builtTension = 0;
+  static thresholdTable instance;
+  static thread_local thresholdTable *active;
+};
+
+// Per-thread table while in scope, so that concurrent runs do not keep
+// rebuilding each other's thresholds
+class thresholdTable::scope {
+ public:
+  scope() : previous(active) { active = &own; }
+  ~scope() { active = previous; }
+  scope(const scope &) = delete;
+  scope(scope &&) = delete;
+  auto operator=(const scope &) -> scope & = delete;
+  auto operator=(scope &&) -> scope & = delete;
+
+ private:
+  thresholdTable own;
+  thresholdTable *previous;
+};
+
+}  // namespace PNM
+
+#endif  // THRESHOLDTABLE_H
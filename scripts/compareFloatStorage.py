@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+#############################################################################
+## Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+## Created:     2018
+## Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+## Licence:     MIT
+#############################################################################
+
+"""Compares a float_storage build of numSCAL against the default build.
+
+Both builds run headless (numSCAL --headless) on the same input folder, each
+in its own working directory, and their results are compared:
+  - absolute permeability and porosity (Results/networkProperties.txt),
+    relative deviation;
+  - the curves of Results/SS_Simulation and Results/USS_Simulation: the
+    float curve is interpolated on the saturations of the double one, and
+    each column is compared relative to its range in the double run.
+
+The deviations are written to a report (precisionComparison.txt in the work
+directory) and the script exits with 1 if any exceeds the tolerance.
+
+Usage:
+  compareFloatStorage.py path/to/double/numSCAL path/to/float/numSCAL
+      [--input folder holding Input_Data and numSCAL_Networks]
+      [--workdir folder for the runs] [--tolerance 0.01] [--timeout 3600]
+"""
+
+import argparse
+import bisect
+import os
+import shutil
+import subprocess
+import sys
+
+
+def prepare_run(binary, input_folder, run_folder, timeout):
+    if os.path.isdir(run_folder):
+        shutil.rmtree(run_folder)
+    os.makedirs(run_folder)
+    for folder in ("Input_Data", "numSCAL_Networks"):
+        source = os.path.join(input_folder, folder)
+        if os.path.isdir(source):
+            shutil.copytree(source, os.path.join(run_folder, folder))
+
+    with open(os.path.join(run_folder, "console.txt"), "w") as console:
+        subprocess.run([os.path.abspath(binary), "--headless"],
+                       cwd=run_folder, stdout=console,
+                       stderr=subprocess.STDOUT, timeout=timeout, check=True)
+
+
+def read_table(path):
+    with open(path) as file:
+        header = file.readline().split()
+        rows = [[float(value) for value in line.split()]
+                for line in file if line.strip()]
+    return header, rows
+
+
+def interpolate(xs, ys, x):
+    i = bisect.bisect_left(xs, x)
+    if i == 0:
+        return ys[0]
+    if i == len(xs):
+        return ys[-1]
+    if xs[i] == xs[i - 1]:
+        return ys[i]
+    weight = (x - xs[i - 1]) / (xs[i] - xs[i - 1])
+    return ys[i - 1] + weight * (ys[i] - ys[i - 1])
+
+
+def compare_properties(double_folder, float_folder):
+    name = os.path.join("Results", "networkProperties.txt")
+    header, reference = read_table(os.path.join(double_folder, name))
+    _, compared = read_table(os.path.join(float_folder, name))
+    deviations = []
+    for column, title in enumerate(header):
+        expected, value = reference[0][column], compared[0][column]
+        scale = abs(expected) if expected != 0 else 1
+        deviations.append((title, abs(value - expected) / scale))
+    return deviations
+
+
+# Curves are keyed on their first column (Sw or time), which is not
+# necessarily monotonic: it is sorted before interpolating
+def compare_curve(reference_path, compared_path):
+    header, reference = read_table(reference_path)
+    _, compared = read_table(compared_path)
+    if not reference or not compared:
+        return [(title, 0.0 if len(reference) == len(compared) else 1.0)
+                for title in header[1:]]
+
+    compared.sort(key=lambda row: row[0])
+    xs = [row[0] for row in compared]
+    deviations = []
+    for column in range(1, len(header)):
+        values = [row[column] for row in reference]
+        scale = max(values) - min(values) or max(abs(v) for v in values) or 1
+        ys = [row[column] for row in compared]
+        worst = max(abs(interpolate(xs, ys, row[0]) - row[column])
+                    for row in reference)
+        deviations.append((header[column], worst / scale))
+    return deviations
+
+
+def compare_curves(double_folder, float_folder):
+    results = []
+    for folder in ("SS_Simulation", "USS_Simulation"):
+        reference_folder = os.path.join(double_folder, "Results", folder)
+        if not os.path.isdir(reference_folder):
+            continue
+        for name in sorted(os.listdir(reference_folder)):
+            if not name.endswith(".txt"):
+                continue
+            compared = os.path.join(float_folder, "Results", folder, name)
+            if not os.path.isfile(compared):
+                results.append((folder + "/" + name, "missing", 1.0))
+                continue
+            for title, deviation in compare_curve(
+                    os.path.join(reference_folder, name), compared):
+                results.append((folder + "/" + name, title, deviation))
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("double_binary")
+    parser.add_argument("float_binary")
+    parser.add_argument("--input", default=".")
+    parser.add_argument("--workdir", default="precisionComparison")
+    parser.add_argument("--tolerance", type=float, default=0.01)
+    parser.add_argument("--timeout", type=float, default=3600)
+    args = parser.parse_args()
+
+    double_folder = os.path.join(args.workdir, "double")
+    float_folder = os.path.join(args.workdir, "float")
+    prepare_run(args.double_binary, args.input, double_folder, args.timeout)
+    prepare_run(args.float_binary, args.input, float_folder, args.timeout)
+
+    rows = [("networkProperties", title, deviation) for title, deviation in
+            compare_properties(double_folder, float_folder)]
+    rows += compare_curves(double_folder, float_folder)
+
+    failed = False
+    report_path = os.path.join(args.workdir, "precisionComparison.txt")
+    with open(report_path, "w") as report:
+        report.write("Tolerance\t%g\n" % args.tolerance)
+        report.write("File\tQuantity\tDeviation\tStatus\n")
+        for source, title, deviation in rows:
+            status = "OK" if deviation <= args.tolerance else "FAILED"
+            failed = failed or status == "FAILED"
+            report.write("%s\t%s\t%.3e\t%s\n" %
+                         (source, title, deviation, status))
+
+    with open(report_path) as report:
+        sys.stdout.write(report.read())
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,265 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "scenarioBatchSimulation.h"
+#include "misc/maths.h"
+#include "misc/memoryReport.h"
+#include "misc/parallel.h"
+#include "misc/scopedtimer.h"
+#include "misc/tools.h"
+#include "misc/userInput.h"
+#include "network/networkmodel.h"
+#include "network/networkstate.h"
+#include "operations/hkClustering.h"
+#include "operations/pnmOperation.h"
+#include "operations/pnmSolver.h"
+#include "operations/thresholdTable.h"
+
+#include <libs/boost/property_tree/ini_parser.hpp>
+#include <libs/boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace PNM {
+
+namespace {
+
+// Grid values are given in the units of Parameters.txt
+void setParameter(userInput &config, const std::string &name, double value) {
+  const double degrees = maths::pi() / 180.;
+
+  if (name == "wettabilityFlag")
+    config.wettability =
+        static_cast<networkWettability>(static_cast<int>(value));
+  else if (name == "minWaterWetTheta")
+    config.minWaterWetTheta = value * degrees;
+  else if (name == "maxWaterWetTheta")
+    config.maxWaterWetTheta = value * degrees;
+  else if (name == "minOilWetTheta")
+    config.minOilWetTheta = value * degrees;
+  else if (name == "maxOilWetTheta")
+    config.maxOilWetTheta = value * degrees;
+  else if (name == "oilWetFraction")
+    config.oilWetFraction = value;
+  else if (name == "OWSurfaceTension")
+    config.OWSurfaceTension = value * 1e-3;
+  else
+    throw std::invalid_argument("Unknown scenario parameter: " + name + "\n");
+}
+
+}  // namespace
+
+scenarioBatchSimulation::scenarioBatchSimulation() {
+  totalScenarios = 0;
+  completedScenarios = 0;
+}
+
+void scenarioBatchSimulation::run() {
+  loadScenarios();
+  writeSummary();
+
+  int workerCount =
+      std::min<int>(parallel::threadCount(), std::max(1, totalScenarios));
+  threadsPerScenario = std::max<int>(1, parallel::threadCount() / workerCount);
+  baseOutputDirectory = userInput::get().outputDirectory;
+  initialState = networkState::capture(network);
+
+  // Concurrent scenarios reach their element states through their threads
+  std::unique_ptr<networkState::concurrentRuns> sharedElements;
+  if (workerCount > 1) sharedElements.reset(new networkState::concurrentRuns);
+
+  nextScenario = 0;
+  completedScenarios = 0;
+  finishedWorkers = 0;
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < workerCount; ++i)
+    workers.emplace_back(&scenarioBatchSimulation::work, this);
+
+  // GUI notifications are all posted from this thread
+  auto interval = std::chrono::duration<double>(
+      std::max(userInput::get().guiUpdateInterval, 0.1));
+  std::unique_lock<std::mutex> lock(scenariosMutex);
+  while (finishedWorkers < workerCount) {
+    progressed.wait_for(lock, interval);
+    lock.unlock();
+    updateGUI();
+    lock.lock();
+  }
+  lock.unlock();
+
+  for (std::thread &worker : workers) worker.join();
+  initialState.reset();
+}
+
+std::string scenarioBatchSimulation::getNotification() {
+  std::lock_guard<std::mutex> lock(scenariosMutex);
+  std::ostringstream ss;
+  ss << "Scenario Batch Simulation \n"
+     << "Completed scenarios: " << completedScenarios << " / "
+     << totalScenarios;
+  return ss.str();
+}
+
+int scenarioBatchSimulation::getProgress() {
+  std::lock_guard<std::mutex> lock(scenariosMutex);
+  return totalScenarios == 0 ? 0 : completedScenarios * 100 / totalScenarios;
+}
+
+void scenarioBatchSimulation::interrupt() {
+  std::lock_guard<std::mutex> lock(scenariosMutex);
+  simulationInterrupted = true;
+  for (simulation *running : runningSimulations) running->interrupt();
+}
+
+void scenarioBatchSimulation::loadScenarios() {
+  boost::property_tree::ptree pt;
+  boost::property_tree::ini_parser::read_ini("Input_Data/Scenarios.txt", pt);
+
+  parameters.clear();
+  wettabilityChanged = false;
+  totalScenarios = 1;
+
+  userInput validated = userInput::get();
+  for (const auto &entry : pt.get_child("Scenarios")) {
+    parameter p;
+    p.name = entry.first;
+
+    std::string list = entry.second.get_value<std::string>();
+    std::replace(list.begin(), list.end(), ',', ' ');
+    std::istringstream values(list);
+    double value;
+    while (values >> value) p.values.push_back(value);
+
+    if (p.values.empty())
+      throw std::invalid_argument("No values for scenario parameter: " +
+                                  p.name + "\n");
+    setParameter(validated, p.name, p.values.front());
+
+    if (p.name != "OWSurfaceTension") wettabilityChanged = true;
+    totalScenarios *= p.values.size();
+    parameters.push_back(p);
+  }
+
+  std::cout << "Scenario batch: " << totalScenarios << " scenarios"
+            << std::endl;
+}
+
+void scenarioBatchSimulation::writeSummary() {
+  std::ofstream file(tools::outputPath("Results/scenarios.txt"));
+  file << "case";
+  for (const parameter &p : parameters) file << "\t" << p.name;
+  file << "\n";
+
+  for (int scenario = 0; scenario < totalScenarios; ++scenario) {
+    file << scenario + 1;
+    for (unsigned i = 0; i < parameters.size(); ++i)
+      file << "\t" << getValue(scenario, i);
+    file << "\n";
+  }
+}
+
+// Scenarios enumerate the grid with the last parameter varying fastest
+double scenarioBatchSimulation::getValue(int scenario,
+                                         int parameterIndex) const {
+  for (int i = parameters.size() - 1; i > parameterIndex; --i)
+    scenario /= parameters[i].values.size();
+  const std::vector<double> &values = parameters[parameterIndex].values;
+  return values[scenario % values.size()];
+}
+
+userInput scenarioBatchSimulation::getScenarioInput(int scenario) const {
+  userInput config = userInput::get();
+  for (unsigned i = 0; i < parameters.size(); ++i)
+    setParameter(config, parameters[i].name, getValue(scenario, i));
+
+  // Scenarios already keep the cores busy
+  config.scenarioBatch = false;
+  config.threads = threadsPerScenario;
+  config.relativePermeabilityWorkers = 0;
+
+  std::ostringstream folder;
+  folder << baseOutputDirectory << "Scenarios/case_" << std::setfill('0')
+         << std::setw(3) << scenario + 1 << "/";
+  config.outputDirectory = folder.str();
+  return config;
+}
+
+void scenarioBatchSimulation::work() {
+  while (true) {
+    int scenario;
+    {
+      std::lock_guard<std::mutex> lock(scenariosMutex);
+      if (simulationInterrupted || nextScenario == totalScenarios) break;
+      scenario = nextScenario++;
+    }
+
+    try {
+      runScenario(scenario);
+    } catch (const std::exception &e) {
+      std::cerr << "Scenario " << scenario + 1 << " failed: " << e.what()
+                << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(scenariosMutex);
+    completedScenarios++;
+    progressed.notify_all();
+  }
+
+  std::lock_guard<std::mutex> lock(scenariosMutex);
+  finishedWorkers++;
+  progressed.notify_all();
+}
+
+// Runs on a worker thread: parameters, element states, operations, clusters
+// and profiling are those of the scenario until it returns
+void scenarioBatchSimulation::runScenario(int scenario) {
+  userInput config = getScenarioInput(scenario);
+  userInput::scope configScope(config);
+  pnmOperation::scope operationScope;
+  hkClustering::scope clusteringScope;
+  pnmSolver::scope solverScope;
+  thresholdTable::scope thresholdScope;
+  ScopedTimer::scope profileScope;
+  memoryReport::scope memoryScope;
+  networkState::scope stateScope(*initialState);
+
+  if (wettabilityChanged) pnmOperation::get(network).assignWettabilities();
+
+  std::shared_ptr<simulation> scenarioSimulation =
+      simulation::createSimulation();
+  scenarioSimulation->setNetwork(network);
+
+  {
+    std::lock_guard<std::mutex> lock(scenariosMutex);
+    if (simulationInterrupted) return;
+    runningSimulations.push_back(scenarioSimulation.get());
+  }
+
+  auto unregister = [this, &scenarioSimulation]() {
+    std::lock_guard<std::mutex> lock(scenariosMutex);
+    runningSimulations.erase(std::find(runningSimulations.begin(),
+                                       runningSimulations.end(),
+                                       scenarioSimulation.get()));
+  };
+
+  try {
+    scenarioSimulation->execute();
+  } catch (...) {
+    unregister();
+    throw;
+  }
+  unregister();
+}
+
+}  // namespace PNM
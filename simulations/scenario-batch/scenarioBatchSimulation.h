@@ -0,0 +1,79 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef SCENARIOBATCHSIMULATION_H
+#define SCENARIOBATCHSIMULATION_H
+
+#include "simulations/simulation.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace PNM {
+
+class userInput;
+class networkState;
+
+// Runs the selected simulation once per scenario of a parameter grid
+// (Input_Data/Scenarios.txt, section [Scenarios]), e.g.
+//   oilWetFraction = 0 0.25 0.5
+//   OWSurfaceTension = 20 30
+// Every combination of the listed values is a scenario, given in the units of
+// Parameters.txt. Scenarios run concurrently on the loaded network, each with
+// its own element states (see networkState::scope), parameters, operations
+// and profiling, and write their results under Scenarios/case_<n>/; the cases
+// are listed in Results/scenarios.txt.
+class scenarioBatchSimulation : public simulation {
+ public:
+  scenarioBatchSimulation();
+  ~scenarioBatchSimulation() override {}
+  scenarioBatchSimulation(const scenarioBatchSimulation &) = delete;
+  scenarioBatchSimulation(scenarioBatchSimulation &&) = delete;
+  auto operator=(const scenarioBatchSimulation &)
+      -> scenarioBatchSimulation & = delete;
+  auto operator=(scenarioBatchSimulation &&)
+      -> scenarioBatchSimulation & = delete;
+
+  virtual void run() override;
+  virtual std::string getNotification() override;
+  virtual int getProgress() override;
+  virtual void interrupt() override;
+
+ private:
+  struct parameter {
+    std::string name;
+    std::vector<double> values;
+  };
+
+  void loadScenarios();
+  void writeSummary();
+  double getValue(int scenario, int parameterIndex) const;
+  userInput getScenarioInput(int scenario) const;
+  void work();
+  void runScenario(int scenario);
+
+  std::vector<parameter> parameters;
+  bool wettabilityChanged;
+  int totalScenarios;
+  int threadsPerScenario;
+  std::string baseOutputDirectory;
+  std::shared_ptr<networkState> initialState;
+
+  std::mutex scenariosMutex;
+  std::condition_variable progressed;
+  int nextScenario;
+  int completedScenarios;
+  int finishedWorkers;
+  std::vector<simulation *> runningSimulations;
+};
+
+}  // namespace PNM
+
+#endif  // SCENARIOBATCHSIMULATION_H
@@ -6,10 +6,14 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "simulation.h"
+#include "misc/memoryReport.h"
 #include "misc/scopedtimer.h"
 #include "misc/tools.h"
 #include "misc/userInput.h"
+#include "network/iterator.h"
+#include "network/networkstate.h"
 #include "simulations/renderer/renderer.h"
+#include "simulations/scenario-batch/scenarioBatchSimulation.h"
 #include "simulations/steady-state-cycle/steadyStateSimulation.h"
 #include "simulations/template-simulation/templateFlowSimulation.h"
 #include "simulations/tracer-flow/tracerFlowSimulation.h"
@@ -21,9 +25,13 @@
 namespace PNM {
 simulation::simulation(QObject *parent) : QObject(parent) {
   simulationInterrupted = false;
+  notificationPending = false;
 }
 
 std::shared_ptr<simulation> simulation::createSimulation() {
+  if (userInput::get().scenarioBatch)
+    return std::make_shared<scenarioBatchSimulation>();
+
   if (userInput::get().twoPhaseSS)
     return std::make_shared<steadyStateSimulation>();
 
@@ -53,14 +61,70 @@ void simulation::setNetwork(const std::shared_ptr<networkModel> &value) {
   network = value;
 }
 
-void simulation::initialise() { tools::createRequiredFolders(); }
+void simulation::setInitialState(const std::shared_ptr<networkState> &value) {
+  initialState = value;
+}
+
+void simulation::initialise() {
+  tools::createRequiredFolders();
+  if (initialState) initialState->restore();
+}
 
 void simulation::finalise() {
   ScopedTimer::printProfileData();
+  memoryReport::get().updateNetworkUsage(network);
+  memoryReport::get().printReport();
   emit finished();
 }
 
-void simulation::updateGUI() { emit notifyGUI(); }
+// Notifications are throttled by wall-clock time and delivered through a
+// queued connection: the GUI picks up the latest snapshot whenever it gets to
+// it, and a new notification is only posted once the previous one was
+// consumed. Headless runs have no receiver and skip the capture entirely.
+void simulation::updateGUI() {
+  if (receivers(SIGNAL(notifyGUI())) == 0) return;
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - lastNotification < std::chrono::duration<double>(
+                                   userInput::get().guiUpdateInterval))
+    return;
+  lastNotification = now;
+
+  publishSnapshot(captureSnapshot());
+}
+
+std::shared_ptr<const simulationSnapshot> simulation::captureSnapshot() {
+  auto frame = std::make_shared<simulationSnapshot>();
+  frame->progress = getProgress();
+  frame->notification = getNotification();
+
+  int size = network->totalNodes + network->totalPores;
+  frame->phases.reserve(size);
+  frame->wettabilities.reserve(size);
+  frame->concentrations.reserve(size);
+  for (element *e : pnmRange<element>(network)) {
+    frame->phases.push_back(e->getPhaseFlag());
+    frame->wettabilities.push_back(e->getWettabilityFlag());
+    frame->concentrations.push_back(float(e->getConcentration()));
+  }
+
+  return frame;
+}
+
+void simulation::publishSnapshot(
+    std::shared_ptr<const simulationSnapshot> frame) {
+  {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshot = frame;
+  }
+  if (!notificationPending.exchange(true)) emit notifyGUI();
+}
+
+std::shared_ptr<const simulationSnapshot> simulation::getSnapshot() {
+  notificationPending = false;
+  std::lock_guard<std::mutex> lock(snapshotMutex);
+  return snapshot;
+}
 
 void simulation::interrupt() { simulationInterrupted = true; }
 
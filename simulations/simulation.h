@@ -9,12 +9,30 @@
 #define SIMULATION_H
 
 #include <QObject>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace PNM {
 
 class networkModel;
+class networkState;
+enum class phase;
+enum class wettability;
+
+// Progress and display data handed over to the GUI. It is captured on the
+// simulation thread, so the GUI never reads the network while it is being
+// updated. Element data follow the pnmRange<element> order (nodes, then pores).
+struct simulationSnapshot {
+  int progress;
+  std::string notification;
+  std::vector<phase> phases;
+  std::vector<wettability> wettabilities;
+  std::vector<float> concentrations;
+};
 
 class simulation : public QObject {
   Q_OBJECT
@@ -23,10 +41,12 @@ class simulation : public QObject {
   static std::shared_ptr<simulation> createSimulation();
   static std::shared_ptr<simulation> createRenderer();
   void setNetwork(const std::shared_ptr<networkModel> &value);
+  void setInitialState(const std::shared_ptr<networkState> &value);
   void execute();
   virtual std::string getNotification() = 0;
   virtual int getProgress() = 0;
   virtual void interrupt();
+  std::shared_ptr<const simulationSnapshot> getSnapshot();
 
  signals:
   void notifyGUI();
@@ -44,9 +64,17 @@ class simulation : public QObject {
   virtual void run() = 0;
   void initialise();
   void finalise();
+  std::shared_ptr<const simulationSnapshot> captureSnapshot();
+  void publishSnapshot(std::shared_ptr<const simulationSnapshot>);
 
   std::shared_ptr<networkModel> network;
+  std::shared_ptr<networkState> initialState;
   bool simulationInterrupted;
+
+  std::mutex snapshotMutex;
+  std::shared_ptr<const simulationSnapshot> snapshot;
+  std::atomic<bool> notificationPending;
+  std::chrono::steady_clock::time_point lastNotification;
 };
 
 }  // namespace PNM
@@ -7,202 +7,42 @@
 
 #include "forcedWaterInjection.h"
 #include "misc/maths.h"
-#include "misc/tools.h"
 #include "misc/userInput.h"
 #include "network/cluster.h"
 #include "network/iterator.h"
-#include "operations/hkClustering.h"
-#include "operations/pnmOperation.h"
-#include "operations/pnmSolver.h"
+#include "operations/thresholdTable.h"
 
-#include <cmath>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
-#include <unordered_set>
+#include <algorithm>
 
 namespace PNM {
 
-forcedWaterInjection::forcedWaterInjection() {}
+forcedWaterInjection::forcedWaterInjection()
+    : quasiStaticSimulation({"Forced Water Injection", "Forced_Water_Injection",
+                             "3-forcedWaterInjection", -2, true, false, 0}) {}
 
 forcedWaterInjection::~forcedWaterInjection() {}
 
-void forcedWaterInjection::run() {
-  initialiseOutputFiles();
-  initialiseCapillaries();
-  initialiseSimulationAttributes();
-
-  while (step < userInput::get().twoPhaseSimulationSteps) {
-    invadeCapillariesAtCurrentPc();
-    dismissTrappedElements();
-    adjustCapillaryVolumes();
-
-    updateOutputFiles();
-    updateVariables();
-    updateGUI();
-
-    if (simulationInterrupted) break;
-  }
-  finalise();
-}
-
-std::string forcedWaterInjection::getNotification() {
-  std::ostringstream ss;
-  ss << "Forced Water Injection Simulation \n"
-     << std::fixed << std::setprecision(2)
-     << "Current PC (psi): " << maths::PaToPsi(currentPc)
-     << " / Sw: " << currentSw;
-  return ss.str();
-}
-
-int forcedWaterInjection::getProgress() {
-  return step / userInput::get().twoPhaseSimulationSteps * 100;
-}
-
-void forcedWaterInjection::initialiseOutputFiles() {
-  tools::initialiseFolder("Network_State/Forced_Water_Injection");
-
-  pcFilename = "Results/SS_Simulation/3-forcedWaterInjectionPcCurve.txt";
-  relPermFilename =
-      "Results/SS_Simulation/3-forcedWaterInjectionRelativePermeabilies.txt";
-
-  std::ofstream file;
-
-  file.open(pcFilename.c_str());
-  file << "Sw\tPc\n";
-  file.close();
-
-  file.open(relPermFilename.c_str());
-  file << "Sw\tKro\tKrw\n";
-  file.close();
-}
-
-void forcedWaterInjection::initialiseSimulationAttributes() {
-  step = 0;
-  currentSw = 0;
-
-  outputCounter = 0;
-  frameCount = 0;
-
-  double effectiveMinRadius =
-      2 * userInput::get().OWSurfaceTension / getMaxPc();
-  double effectiveMaxRadius =
-      2 * userInput::get().OWSurfaceTension / getMinPc();
-  radiusStep = (effectiveMaxRadius - effectiveMinRadius) /
-               userInput::get().twoPhaseSimulationSteps;
-  currentRadius = effectiveMaxRadius - radiusStep;
-  currentPc = -2 * userInput::get().OWSurfaceTension / currentRadius;
-
-  elementsToInvade.clear();
-  for (element *e : pnmRange<element>(network))
-    if (e->getPhaseFlag() == phase::oil) elementsToInvade.insert(e);
-}
-
-void forcedWaterInjection::initialiseCapillaries() {}
-
 double forcedWaterInjection::getMinPc() {
-  double minPc(1e20);
-  for (element *e : pnmRange<element>(network)) {
-    double pc = std::abs(e->getEntryPressureCoefficient() *
-                         userInput::get().OWSurfaceTension *
-                         std::cos(e->getTheta()) / e->getRadius());
-    if (pc < minPc) minPc = pc;
-  }
-  return minPc;
+  return thresholdTable::get(network).getEntryPressureRange(true).min;
 }
 
 double forcedWaterInjection::getMaxPc() {
-  double maxPc(-1e20);
-  for (element *e : pnmRange<element>(network)) {
-    double pc = std::abs(e->getEntryPressureCoefficient() *
-                         userInput::get().OWSurfaceTension *
-                         std::cos(e->getTheta()) / e->getRadius());
-    if (pc > maxPc) maxPc = pc;
-  }
-  return maxPc;
-}
-
-void forcedWaterInjection::invadeCapillariesAtCurrentPc() {
-  bool stillMore = true;
-  while (stillMore) {
-    stillMore = false;
-
-    hkClustering::get(network).clusterWaterConductorElements();
-    hkClustering::get(network).clusterOilConductorElements();
-
-    std::vector<element *> invadedElements;
-    for (element *e : elementsToInvade) {
-      if (isInvadable(e)) invadedElements.push_back(e);
-    }
-
-    for (element *e : invadedElements) {
-      fillWithWater(e);
-      elementsToInvade.erase(e);
-      stillMore = true;
-    }
-
-    updateOutputFiles();
-    updateGUI();
-
-    if (simulationInterrupted) break;
-  }
-}
-
-void forcedWaterInjection::dismissTrappedElements() {
-  std::vector<element *> trappedElements;
-  for (element *e : elementsToInvade) {
-    if (!e->getClusterOilConductor()->getOutlet()) trappedElements.push_back(e);
-  }
-
-  for (element *e : trappedElements) elementsToInvade.erase(e);
+  return thresholdTable::get(network).getEntryPressureRange(true).max;
 }
 
-void forcedWaterInjection::adjustCapillaryVolumes() {
-  double waterVolume(0);
-
-  for (element *e : pnmRange<element>(network)) {
-    if (e->getPhaseFlag() == phase::oil &&
-        e->getWettabilityFlag() == wettability::waterWet)
-      waterVolume += e->getWaterFilmVolume();
-
-    if (e->getPhaseFlag() == phase::oil &&
-        e->getWettabilityFlag() == wettability::oilWet)
-      waterVolume += e->getWaterFilmVolume();
-
-    if (e->getPhaseFlag() == phase::water &&
-        e->getWettabilityFlag() == wettability::oilWet) {
-      if (e->getOilLayerActivated() &&
-          e->getClusterWaterConductor()->getInlet() &&
-          e->getClusterOilConductor()->getOutlet())
-        adjustVolumetrics(e);
-      waterVolume += e->getEffectiveVolume() + e->getWaterFilmVolume();
-    }
-
-    if (e->getPhaseFlag() == phase::water &&
-        e->getWettabilityFlag() == wettability::waterWet)
-      waterVolume += e->getVolume();
-  }
-
-  currentSw = waterVolume / network->totalNetworkVolume;
+void forcedWaterInjection::seedFrontiers() {
+  for (element *e : pnmRange<element>(network))
+    if (e->getPhaseFlag() == phase::oil) insertCandidate(e);
 }
 
+// The entry pressure is already checked by the frontier
 bool forcedWaterInjection::isInvadable(element *e) {
-  bool isInvadable = false;
-
-  if ((e->getType() == capillaryType::throat &&
-       (e->getInlet() || isConnectedToInletCluster(e)) &&
-       e->getClusterOilConductor()->getOutlet()) ||
-      (e->getType() == capillaryType::poreBody &&
-       isConnectedToInletCluster(e) &&
-       e->getClusterOilConductor()->getOutlet())) {
-    double entryPressure = e->getEntryPressureCoefficient() *
-                           userInput::get().OWSurfaceTension *
-                           std::cos(e->getTheta()) / e->getRadius();
-    if (currentPc - 1e-5 <= entryPressure) isInvadable = true;
-  }
-
-  return isInvadable;
+  return (e->getType() == capillaryType::throat &&
+          (e->getInlet() || isConnectedToInletCluster(e)) &&
+          e->getClusterOilConductor()->getOutlet()) ||
+         (e->getType() == capillaryType::poreBody &&
+          isConnectedToInletCluster(e) &&
+          e->getClusterOilConductor()->getOutlet());
 }
 
 bool forcedWaterInjection::isConnectedToInletCluster(element *e) {
@@ -216,7 +56,7 @@ bool forcedWaterInjection::isConnectedToInletCluster(element *e) {
   return connectedToInletCluster;
 }
 
-void forcedWaterInjection::fillWithWater(element *e) {
+void forcedWaterInjection::fill(element *e) {
   e->setPhaseFlag(phase::water);
   e->setWaterConductor(true);
   e->setOilFraction(0);
@@ -233,14 +73,29 @@ void forcedWaterInjection::fillWithWater(element *e) {
   }
 }
 
+bool forcedWaterInjection::isTrapped(element *e) {
+  return !e->getClusterOilConductor()->getOutlet();
+}
+
+bool forcedWaterInjection::carriesFilm(element *e) {
+  return e->getPhaseFlag() == phase::water &&
+         e->getWettabilityFlag() == wettability::oilWet &&
+         e->getOilLayerActivated();
+}
+
+bool forcedWaterInjection::isFilmConnected(element *e) {
+  return e->getClusterWaterConductor()->getInlet() &&
+         e->getClusterOilConductor()->getOutlet();
+}
+
 void forcedWaterInjection::adjustVolumetrics(element *e) {
-  double rSquared = std::pow(userInput::get().OWSurfaceTension / currentPc, 2);
   double filmVolume =
-      std::min(rSquared * e->getFilmAreaCoefficient() * e->getLength(),
+      std::min(filmRadiusSquared * getFilmVolumeCoefficient(e),
                (1 - 4 * maths::pi() * e->getShapeFactor()) * e->getVolume());
   double effectiveOilFilmVolume =
       std::max(0.0, filmVolume - e->getWaterFilmVolume());
-  double filmConductance = rSquared * effectiveOilFilmVolume / e->getLength() /
+  double filmConductance = filmRadiusSquared * effectiveOilFilmVolume /
+                           e->getLength() /
                            (userInput::get().oilViscosity * e->getLength());
 
   e->setOilFilmVolume(effectiveOilFilmVolume);
@@ -249,44 +104,4 @@ void forcedWaterInjection::adjustVolumetrics(element *e) {
                         e->getWaterFilmVolume());
 }
 
-void forcedWaterInjection::updateVariables() {
-  step++;
-
-  if (step != userInput::get().twoPhaseSimulationSteps) {
-    currentRadius -= radiusStep;
-    currentPc = -2 * userInput::get().OWSurfaceTension / currentRadius;
-  }
-}
-
-void forcedWaterInjection::updateOutputFiles() {
-  if (std::abs(outputCounter - currentSw) < 0.01) return;
-
-  std::ofstream file;
-
-  file.open(pcFilename, std::ofstream::app);
-  file << currentSw << "\t" << currentPc << std::endl;
-  file.close();
-
-  if (userInput::get().relativePermeabilitiesCalculation) {
-    auto relPerms = pnmSolver::get(network).calculateRelativePermeabilities();
-
-    file.open(relPermFilename, std::ofstream::app);
-    file << currentSw << "\t" << relPerms.first << "\t" << relPerms.second
-         << std::endl;
-    file.close();
-  }
-
-  generateNetworkStateFiles();
-
-  outputCounter = currentSw;
-}
-
-void forcedWaterInjection::generateNetworkStateFiles() {
-  if (!userInput::get().extractDataSS) return;
-
-  pnmOperation::get(network).generateNetworkState(frameCount,
-                                                  "Forced_Water_Injection");
-  frameCount++;
-}
-
 }  // namespace PNM
@@ -0,0 +1,169 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "invasionFrontier.h"
+#include "network/iterator.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace PNM {
+
+namespace {
+// Same tolerance as the former isInvadable checks
+const double pcTolerance = 1e-5;
+
+// Min-heap on the key, ties broken by network order
+struct laterEntry {
+  template <typename T>
+  bool operator()(const T &a, const T &b) const {
+    return a.key > b.key || (a.key == b.key && a.index > b.index);
+  }
+};
+}  // namespace
+
+void invasionFrontier::initialise(std::shared_ptr<networkModel> network,
+                                  direction dir, thresholdFunction f) {
+  int size = network->totalNodes + network->totalPores;
+  poreOffset = network->totalNodes;
+  // Keys are signed so that the next element to reach its threshold is always
+  // the smallest one, whichever way Pc moves
+  sign = dir == direction::increasingPc ? 1 : -1;
+  threshold = std::move(f);
+
+  heap.clear();
+  readyElements.clear();
+  states.assign(size, memberState::absent);
+  versions.assign(size, 0);
+  keys.assign(size, 0);
+}
+
+void invasionFrontier::insert(element *e) {
+  int i = index(e);
+  if (states[i] != memberState::absent) return;
+  push(e, i);
+}
+
+void invasionFrontier::erase(element *e) {
+  int i = index(e);
+  if (states[i] == memberState::absent) return;
+  states[i] = memberState::absent;
+  versions[i]++;
+}
+
+// Recomputes the threshold of a member whose invasion criteria changed (e.g.
+// its number of invaded neighbours). Ready elements go back to the queue,
+// and are popped again by the next advance if they still qualify.
+void invasionFrontier::update(element *e) {
+  int i = index(e);
+  if (states[i] == memberState::absent) return;
+  if (sign * threshold(e) == keys[i]) return;
+  versions[i]++;
+  push(e, i);
+}
+
+bool invasionFrontier::contains(element *e) const {
+  return states[index(e)] != memberState::absent;
+}
+
+void invasionFrontier::advance(double pc) {
+  readyElements.erase(
+      std::remove_if(readyElements.begin(), readyElements.end(),
+                     [this](element *e) {
+                       return states[index(e)] != memberState::ready;
+                     }),
+      readyElements.end());
+
+  double limit = sign * pc + pcTolerance;
+  bool added = false;
+  while (!heap.empty() && heap.front().key <= limit) {
+    std::pop_heap(heap.begin(), heap.end(), laterEntry());
+    entry top = heap.back();
+    heap.pop_back();
+
+    if (top.version != versions[top.index] ||
+        states[top.index] != memberState::pending)
+      continue;
+
+    states[top.index] = memberState::ready;
+    readyElements.push_back(top.e);
+    added = true;
+  }
+
+  // Elements left ready by earlier steps come before the new ones; restore
+  // the threshold order (mostly sorted already)
+  auto earlier = [this](element *a, element *b) {
+    int i = index(a), j = index(b);
+    return keys[i] < keys[j] || (keys[i] == keys[j] && i < j);
+  };
+  if (added)
+    std::sort(readyElements.begin(), readyElements.end(), earlier);
+}
+
+// Pc at which the next pending element becomes ready: advancing to any Pc
+// before it selects nothing new. Infinite in the direction of Pc when nothing
+// is pending.
+double invasionFrontier::nextThreshold() {
+  while (!heap.empty()) {
+    const entry &top = heap.front();
+    if (top.version == versions[top.index] &&
+        states[top.index] == memberState::pending)
+      return sign * top.key;
+
+    std::pop_heap(heap.begin(), heap.end(), laterEntry());
+    heap.pop_back();
+  }
+  return sign * std::numeric_limits<double>::infinity();
+}
+
+// Whether advancing to pc would make a pending element ready
+bool invasionFrontier::reaches(double pc) {
+  return sign * nextThreshold() <= sign * pc + pcTolerance;
+}
+
+std::vector<element *> invasionFrontier::selectReady(
+    const elementPredicate &canInvade) {
+  std::vector<element *> selected;
+  for (element *e : readyElements)
+    if (states[index(e)] == memberState::ready && canInvade(e))
+      selected.push_back(e);
+  return selected;
+}
+
+void invasionFrontier::removeIf(const elementPredicate &toRemove) {
+  for (element *e : readyElements)
+    if (states[index(e)] == memberState::ready && toRemove(e)) erase(e);
+
+  // Stale queue entries are dropped on the way
+  std::vector<entry> kept;
+  kept.reserve(heap.size());
+  for (const entry &n : heap) {
+    if (n.version != versions[n.index] ||
+        states[n.index] != memberState::pending)
+      continue;
+    if (toRemove(n.e))
+      erase(n.e);
+    else
+      kept.push_back(n);
+  }
+  heap.swap(kept);
+  std::make_heap(heap.begin(), heap.end(), laterEntry());
+}
+
+int invasionFrontier::index(element *e) const {
+  return e->getType() == capillaryType::throat ? poreOffset + e->getId() - 1
+                                               : e->getId() - 1;
+}
+
+void invasionFrontier::push(element *e, int i) {
+  states[i] = memberState::pending;
+  keys[i] = sign * threshold(e);
+  heap.push_back({keys[i], i, versions[i], e});
+  std::push_heap(heap.begin(), heap.end(), laterEntry());
+}
+
+}  // namespace PNM
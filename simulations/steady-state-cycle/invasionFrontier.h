@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef INVASIONFRONTIER_H
+#define INVASIONFRONTIER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace PNM {
+
+class networkModel;
+class element;
+
+// Invasion candidates of a quasi-static process, kept in a priority queue
+// ordered by threshold capillary pressure. Thresholds are computed when an
+// element enters the frontier (or is updated), and advancing Pc only pops the
+// elements whose threshold has been reached. Popped elements stay ready until
+// they are invaded or removed: the connectivity part of the invasion criteria
+// depends on clustering and is checked by the process on ready elements only.
+// Ready elements are handed out in threshold order, ties broken by network
+// order, so that the invasion sequence is the same from one run to the next.
+class invasionFrontier {
+ public:
+  enum class direction { increasingPc, decreasingPc };
+  using thresholdFunction = std::function<double(element *)>;
+  using elementPredicate = std::function<bool(element *)>;
+
+  void initialise(std::shared_ptr<networkModel> network, direction,
+                  thresholdFunction);
+  void insert(element *);
+  void erase(element *);
+  void update(element *);
+  bool contains(element *) const;
+  void advance(double pc);
+  double nextThreshold();
+  bool reaches(double pc);
+  std::vector<element *> selectReady(const elementPredicate &);
+  void removeIf(const elementPredicate &);
+
+ protected:
+  enum class memberState : char { absent, pending, ready };
+
+  struct entry {
+    double key;
+    int index;
+    unsigned version;
+    element *e;
+  };
+
+  int index(element *) const;
+  void push(element *, int index);
+
+  std::vector<entry> heap;
+  std::vector<element *> readyElements;
+  std::vector<memberState> states;
+  std::vector<unsigned> versions;
+  std::vector<double> keys;
+  thresholdFunction threshold;
+  double sign = 1;
+  int poreOffset = 0;
+};
+
+}  // namespace PNM
+
+#endif  // INVASIONFRONTIER_H
@@ -6,102 +6,102 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "primaryDrainage.h"
-#include "misc/maths.h"
 #include "misc/tools.h"
 #include "misc/userInput.h"
 #include "network/cluster.h"
 #include "network/iterator.h"
 #include "operations/hkClustering.h"
 #include "operations/pnmOperation.h"
-#include "operations/pnmSolver.h"
-
-#include <cmath>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
-#include <unordered_set>
+#include "operations/thresholdTable.h"
 
 namespace PNM {
 
-primaryDrainage::primaryDrainage(double _finalSwi) { finalSwi = _finalSwi; }
+primaryDrainage::primaryDrainage(double _finalSwi)
+    : quasiStaticSimulation({"Primary Drainage", "Primary_Drainage",
+                             "1-primaryDrainage", 2, true, false, 1}) {
+  finalSwi = _finalSwi;
+  waterConductorsChanged = true;
+}
 
 primaryDrainage::~primaryDrainage() {}
 
-void primaryDrainage::run() {
-  initialiseOutputFiles();
+// Setup step of the simulations starting from Swi: the Pc steps, invasion
+// and trapping of run(), without output files, relative permeabilities nor
+// GUI updates. Pc jumps from one step to the first step reaching the next
+// frontier threshold: nothing can be invaded or trapped in between, and Sw
+// only decreases there as the films thin, so the skipped steps are only
+// evaluated, by bisection, if Sw falls below finalSwi before the threshold.
+void primaryDrainage::drainToFinalSwi() {
+  silent = true;
   initialiseCapillaries();
   initialiseSimulationAttributes();
 
-  while (step < userInput::get().twoPhaseSimulationSteps) {
-    invadeCapillariesAtCurrentPc();
-    dismissTrappedElements();
-    adjustCapillaryVolumes();
+  struct pcStep {
+    int step;
+    double radius;
+    double pc;
+  };
+  auto moveTo = [this](const pcStep &s) {
+    step = s.step;
+    currentRadius = s.radius;
+    currentPc = s.pc;
+  };
+
+  int steps = userInput::get().twoPhaseSimulationSteps;
+  bool adaptive = userInput::get().pcSteppingMode == pcStepping::adaptive;
+  std::vector<pcStep> skipped;
+
+  while (step < steps) {
+    if (bulkFrontier.reaches(currentPc)) {
+      invadeCapillariesViaBulk();
+      dismissTrappedElements();
+    }
+    updateCapillaryVolumes();
 
-    updateOutputFiles();
+    if (currentSw < finalSwi) break;
     updateVariables();
-    checkTerminationCondition();
-    updateGUI();
-
-    if (simulationInterrupted) break;
-  }
-  finalise();
-}
+    if (adaptive) continue;  // already jumps to the thresholds
 
-std::string primaryDrainage::getNotification() {
-  std::ostringstream ss;
-  ss << "Primary Drainage Simulation \n"
-     << std::fixed << std::setprecision(2)
-     << "Current PC (psi): " << maths::PaToPsi(currentPc)
-     << " / Sw: " << currentSw;
-  return ss.str();
-}
+    skipped.clear();
+    while (step < steps && !bulkFrontier.reaches(currentPc)) {
+      skipped.push_back({step, currentRadius, currentPc});
+      updateVariables();
+    }
+    if (skipped.empty()) continue;
+
+    pcStep reached = {step, currentRadius, currentPc};
+    moveTo(skipped.back());
+    updateCapillaryVolumes();
+    if (currentSw >= finalSwi) {
+      moveTo(reached);
+      continue;
+    }
 
-int primaryDrainage::getProgress() {
-  return step / userInput::get().twoPhaseSimulationSteps * 100;
+    size_t low = 0, high = skipped.size() - 1;
+    while (low < high) {
+      size_t middle = (low + high) / 2;
+      moveTo(skipped[middle]);
+      updateCapillaryVolumes();
+      if (currentSw < finalSwi)
+        high = middle;
+      else
+        low = middle + 1;
+    }
+    moveTo(skipped[low]);
+    updateCapillaryVolumes();
+    break;
+  }
+  finaliseCapillaries();
 }
 
 void primaryDrainage::initialiseOutputFiles() {
-  tools::initialiseFolder("Results/SS_Simulation");
-
-  tools::initialiseFolder("Network_State/Primary_Drainage");
-
-  pcFilename = "Results/SS_Simulation/1-primaryDrainagePcCurve.txt";
-  relPermFilename =
-      "Results/SS_Simulation/1-primaryDrainageRelativePermeabilies.txt";
-
-  std::ofstream file;
-
-  file.open(pcFilename.c_str());
-  file << "Sw\tPc\n";
-  file.close();
-
-  file.open(relPermFilename.c_str());
-  file << "Sw\tKro\tKrw\n";
-  file.close();
-}
-
-void primaryDrainage::initialiseSimulationAttributes() {
-  step = 0;
-  currentSw = 1;
-
-  outputCounter = 0;
-  frameCount = 0;
-
-  double effectiveMinRadius =
-      2 * userInput::get().OWSurfaceTension / getMaxPc();
-  double effectiveMaxRadius =
-      2 * userInput::get().OWSurfaceTension / getMinPc();
-  radiusStep = (effectiveMaxRadius - effectiveMinRadius) /
-               userInput::get().twoPhaseSimulationSteps;
-  currentRadius = effectiveMaxRadius - radiusStep;
-  currentPc = 2 * userInput::get().OWSurfaceTension / currentRadius;
-
-  elementsToInvade.clear();
-  for (pore *e : pnmInlet(network)) elementsToInvade.insert(e);
+  tools::initialiseFolder(tools::outputPath("Results/SS_Simulation"));
+  quasiStaticSimulation::initialiseOutputFiles();
 }
 
 void primaryDrainage::initialiseCapillaries() {
+  pnmOperation::get(network).releaseTracerAttributes();
+  pnmOperation::get(network).backupWettability();
   pnmOperation::get(network).assignWWWettability();
   pnmOperation::get(network).fillWithWater();
   pnmOperation::get(network).assignHalfAngles();
@@ -120,101 +120,42 @@ void primaryDrainage::initialiseCapillaries() {
     e->setOilFilmConductivity(0);
     e->setOilLayerActivated(false);
   }
+  waterConductorsChanged = true;
+}
+
+void primaryDrainage::finaliseCapillaries() {
+  pnmOperation::get(network).restoreWettability();
+  pnmOperation::get(network).assignFilmsStability();
 }
 
 double primaryDrainage::getMinPc() {
-  double minPc(1e20);
-  for (element *e : pnmRange<element>(network)) {
-    double pc = e->getEntryPressureCoefficient() *
-                userInput::get().OWSurfaceTension * std::cos(e->getTheta()) /
-                e->getRadius();
-    if (pc < minPc) minPc = pc;
-  }
-  return minPc;
+  return thresholdTable::get(network).getEntryPressureRange().min;
 }
 
 double primaryDrainage::getMaxPc() {
-  double maxPc(-1e20);
-  for (element *e : pnmRange<element>(network)) {
-    double pc = e->getEntryPressureCoefficient() *
-                userInput::get().OWSurfaceTension * std::cos(e->getTheta()) /
-                e->getRadius();
-    if (pc > maxPc) maxPc = pc;
-  }
-  return maxPc;
+  return thresholdTable::get(network).getEntryPressureRange().max;
 }
 
-void primaryDrainage::invadeCapillariesAtCurrentPc() {
-  bool stillMore = true;
-  while (stillMore) {
-    stillMore = false;
-    hkClustering::get(network).clusterWaterConductorElements();
-
-    std::vector<element *> invadedElements;
-    for (element *e : elementsToInvade) {
-      if (isInvadable(e)) invadedElements.push_back(e);
-    }
-
-    for (element *e : invadedElements) {
-      fillWithOil(e);
-      elementsToInvade.erase(e);
-      addNeighboorsToElementsToInvade(e);
-
-      stillMore = true;
-    }
-
-    updateOutputFiles();
-    checkTerminationCondition();
-    updateGUI();
-
-    if (simulationInterrupted) break;
-  }
+void primaryDrainage::seedFrontiers() {
+  for (pore *e : pnmInlet(network)) insertCandidate(e);
 }
 
-void primaryDrainage::dismissTrappedElements() {
-  std::vector<element *> trappedElements;
-  for (element *e : elementsToInvade) {
-    if (!e->getClusterWaterConductor()->getOutlet())
-      trappedElements.push_back(e);
-  }
-
-  for (element *e : trappedElements) elementsToInvade.erase(e);
-}
-
-void primaryDrainage::adjustCapillaryVolumes() {
-  double waterVolume(0);
-
-  for (element *e : pnmRange<element>(network)) {
-    if (e->getPhaseFlag() == phase::oil) {
-      if (e->getWaterCornerActivated() &&
-          e->getClusterWaterConductor()->getOutlet()) {
-        adjustVolumetrics(e);
-      }
-      waterVolume += e->getWaterFilmVolume();
-    }
-
-    if (e->getPhaseFlag() == phase::water) waterVolume += e->getVolume();
-  }
-
-  currentSw = waterVolume / network->totalNetworkVolume;
+// The water conductors only change when an element without water films is
+// invaded: their clusters are kept otherwise
+void primaryDrainage::clusterElements() {
+  if (!waterConductorsChanged) return;
+  hkClustering::get(network).clusterWaterConductorElements();
+  waterConductorsChanged = false;
 }
 
+// The entry pressure is already checked by the frontier
 bool primaryDrainage::isInvadable(element *e) {
-  double entryPressure = e->getEntryPressureCoefficient() *
-                         userInput::get().OWSurfaceTension *
-                         std::cos(e->getTheta()) / e->getRadius();
-  return currentPc + 1e-5 >= entryPressure &&
-         e->getClusterWaterConductor()->getOutlet();
-}
-
-void primaryDrainage::addNeighboorsToElementsToInvade(element *e) {
-  for (element *n : e->getNeighboors())
-    if (n->getPhaseFlag() == phase::water &&
-        e->getClusterWaterConductor()->getOutlet())
-      elementsToInvade.insert(n);
+  return e->getClusterWaterConductor()->getOutlet();
 }
 
-void primaryDrainage::fillWithOil(element *e) {
+void primaryDrainage::fill(element *e) {
+  if (e->getWaterConductor() && !e->getWaterCanFlowViaFilm())
+    waterConductorsChanged = true;
   e->setPhaseFlag(phase::oil);
   e->setOilConductor(true);
   e->setOilFraction(1);
@@ -226,64 +167,39 @@ void primaryDrainage::fillWithOil(element *e) {
     e->setWaterConductor(false);
 }
 
-void primaryDrainage::adjustVolumetrics(element *e) {
-  double rSquared = std::pow(userInput::get().OWSurfaceTension / currentPc, 2);
-  double filmVolume = rSquared * e->getFilmAreaCoefficient() * e->getLength();
-  double filmConductivity = rSquared * filmVolume / e->getLength() /
-                            (userInput::get().waterViscosity * e->getLength());
-
-  e->setWaterFilmVolume(filmVolume);
-  e->setWaterFilmConductivity(filmConductivity);
-  e->setEffectiveVolume(e->getVolume() - e->getWaterFilmVolume());
+// Oil invades from the inlet: the water neighbours of invaded elements join
+// the frontier
+void primaryDrainage::updateFrontiers(element *e) {
+  for (element *n : e->getNeighboors())
+    if (n->getPhaseFlag() == phase::water &&
+        e->getClusterWaterConductor()->getOutlet())
+      insertCandidate(n);
 }
 
-void primaryDrainage::updateVariables() {
-  step++;
-
-  if (step != userInput::get().twoPhaseSimulationSteps) {
-    currentRadius -= radiusStep;
-    currentPc = 2 * userInput::get().OWSurfaceTension / currentRadius;
-  }
+bool primaryDrainage::isTrapped(element *e) {
+  return !e->getClusterWaterConductor()->getOutlet();
 }
 
-void primaryDrainage::checkTerminationCondition() {
-  if (currentSw < finalSwi) simulationInterrupted = true;
+bool primaryDrainage::carriesFilm(element *e) {
+  return e->getPhaseFlag() == phase::oil && e->getWaterCornerActivated();
 }
 
-void primaryDrainage::updateOutputFiles() {
-  if (std::abs(outputCounter - currentSw) < 0.01) return;
-
-  std::ofstream file;
-
-  file.open(pcFilename, std::ofstream::app);
-  file << currentSw << "\t" << currentPc << std::endl;
-  file.close();
-
-  if (userInput::get().relativePermeabilitiesCalculation) {
-    auto relPerms = pnmSolver::get(network).calculateRelativePermeabilities();
-
-    file.open(relPermFilename, std::ofstream::app);
-    file << currentSw << "\t" << relPerms.first << "\t" << relPerms.second
-         << std::endl;
-    file.close();
-  }
-
-  generateNetworkStateFiles();
-
-  outputCounter = currentSw;
+bool primaryDrainage::isFilmConnected(element *e) {
+  return e->getClusterWaterConductor()->getOutlet();
 }
 
-void primaryDrainage::generateNetworkStateFiles() {
-  if (!userInput::get().extractDataSS) return;
+void primaryDrainage::adjustVolumetrics(element *e) {
+  double filmVolume = filmRadiusSquared * getFilmVolumeCoefficient(e);
+  double filmConductivity = filmRadiusSquared * filmVolume / e->getLength() /
+                            (userInput::get().waterViscosity * e->getLength());
 
-  pnmOperation::get(network).generateNetworkState(frameCount,
-                                                  "Primary_Drainage");
-  frameCount++;
+  e->setWaterFilmVolume(filmVolume);
+  e->setWaterFilmConductivity(filmConductivity);
+  e->setEffectiveVolume(e->getVolume() - e->getWaterFilmVolume());
 }
 
-void primaryDrainage::finalise() {
-  pnmOperation::get(network).restoreWettability();
-  pnmOperation::get(network).assignFilmsStability();
+void primaryDrainage::checkTerminationCondition() {
+  if (currentSw < finalSwi) simulationInterrupted = true;
 }
 
 }  // namespace PNM
@@ -8,14 +8,12 @@
 #ifndef PRIMARYDRAINAGE_H
 #define PRIMARYDRAINAGE_H
 
-#include "simulations/simulation.h"
-
-#include <unordered_set>
+#include "quasiStaticSimulation.h"
 
 namespace PNM {
 class element;
 
-class primaryDrainage : public simulation {
+class primaryDrainage : public quasiStaticSimulation {
  public:
   primaryDrainage(double _finalSwi = 0);
   ~primaryDrainage() override;
@@ -24,40 +22,28 @@ class primaryDrainage : public simulation {
   auto operator=(const primaryDrainage &) -> primaryDrainage & = delete;
   auto operator=(primaryDrainage &&) -> primaryDrainage & = delete;
 
-  virtual void run() override;
-  virtual std::string getNotification() override;
-  virtual int getProgress() override;
+  // Drains straight to finalSwi, without output files nor GUI updates
+  void drainToFinalSwi();
 
  private:
-  void initialiseOutputFiles();
-  void initialiseSimulationAttributes();
-  void initialiseCapillaries();
-  double getMinPc();
-  double getMaxPc();
-  void invadeCapillariesAtCurrentPc();
-  void dismissTrappedElements();
-  void adjustCapillaryVolumes();
-  bool isInvadable(element *);
-  void addNeighboorsToElementsToInvade(element *);
-  void fillWithOil(element *);
-  void adjustVolumetrics(element *);
-  void updateOutputFiles();
-  void generateNetworkStateFiles();
-  void updateVariables();
-  void checkTerminationCondition();
-  void finalise();
+  void initialiseOutputFiles() override;
+  void initialiseCapillaries() override;
+  void finaliseCapillaries() override;
+  double getMinPc() override;
+  double getMaxPc() override;
+  void seedFrontiers() override;
+  void clusterElements() override;
+  bool isInvadable(element *) override;
+  void fill(element *) override;
+  void updateFrontiers(element *) override;
+  bool isTrapped(element *) override;
+  bool carriesFilm(element *) override;
+  bool isFilmConnected(element *) override;
+  void adjustVolumetrics(element *) override;
+  void checkTerminationCondition() override;
 
   double finalSwi;
-  int step;
-  double radiusStep;
-  double currentRadius;
-  double currentPc;
-  double currentSw;
-  double outputCounter;
-  int frameCount;
-  std::string pcFilename;
-  std::string relPermFilename;
-  std::unordered_set<element *> elementsToInvade;
+  bool waterConductorsChanged;  // since the last clustering
 };
 
 }  // namespace PNM
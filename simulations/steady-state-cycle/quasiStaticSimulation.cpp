@@ -0,0 +1,388 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "quasiStaticSimulation.h"
+#include "misc/maths.h"
+#include "misc/scopedtimer.h"
+#include "misc/tools.h"
+#include "misc/userInput.h"
+#include "network/iterator.h"
+#include "operations/hkClustering.h"
+#include "operations/pnmOperation.h"
+#include "operations/pnmSolver.h"
+#include "operations/thresholdTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace PNM {
+
+quasiStaticSimulation::quasiStaticSimulation(
+    const processDescription &_description)
+    : description(_description), silent(false) {}
+
+void quasiStaticSimulation::run() {
+  initialiseOutputFiles();
+  initialiseCapillaries();
+  initialiseSimulationAttributes();
+
+  while (step < userInput::get().twoPhaseSimulationSteps) {
+    invadeCapillariesAtCurrentPc();
+    dismissTrappedElements();
+    updateCapillaryVolumes();
+
+    updateOutputFiles();
+    updateVariables();
+    checkTerminationCondition();
+    updateGUI();
+
+    if (simulationInterrupted) break;
+  }
+  relativePermeabilities.finish();
+  finaliseCapillaries();
+}
+
+std::string quasiStaticSimulation::getNotification() {
+  std::ostringstream ss;
+  ss << description.title << " Simulation \n"
+     << std::fixed << std::setprecision(2)
+     << "Current PC (psi): " << maths::PaToPsi(currentPc)
+     << " / Sw: " << currentSw;
+  return ss.str();
+}
+
+int quasiStaticSimulation::getProgress() {
+  return step * 100 / userInput::get().twoPhaseSimulationSteps;
+}
+
+void quasiStaticSimulation::clusterElements() {
+  hkClustering::get(network).clusterWaterConductorElements();
+  hkClustering::get(network).clusterOilConductorElements();
+}
+
+double quasiStaticSimulation::getEntryPressure(element *e) {
+  return thresholdTable::get(network).getEntryPressure(e);
+}
+
+double quasiStaticSimulation::getSnapOffPressure(element *e) {
+  return thresholdTable::get(network).getSnapOffPressure(e);
+}
+
+void quasiStaticSimulation::initialiseOutputFiles() {
+  tools::initialiseFolder(
+      tools::outputPath("Network_State/" + description.name));
+
+  std::string resultsFolder = tools::outputPath("Results/SS_Simulation/");
+  pcFilename = resultsFolder + description.resultsPrefix + "PcCurve.txt";
+  relPermFilename =
+      resultsFolder + description.resultsPrefix + "RelativePermeabilies.txt";
+
+  std::ofstream file;
+
+  file.open(pcFilename.c_str());
+  file << "Sw\tPc\n";
+  file.close();
+
+  file.open(relPermFilename.c_str());
+  file << "Sw\tKro\tKrw\n";
+  file.close();
+}
+
+void quasiStaticSimulation::initialiseSimulationAttributes() {
+  step = 0;
+  currentSw = description.initialSw;
+
+  curvesOutput.initialise(userInput::get().curvesOutput);
+  relativePermeabilitiesOutput.initialise(
+      userInput::get().relativePermeabilitiesOutput);
+  networkStatesOutput.initialise(userInput::get().networkStatesOutput);
+  frameCount = 0;
+  if (!silent)
+    relativePermeabilities.start(relPermFilename,
+                                 userInput::get().relativePermeabilityWorkers);
+
+  double curvature =
+      std::abs(description.pcFactor) * userInput::get().OWSurfaceTension;
+  double effectiveMinRadius = curvature / getMaxPc();
+  double effectiveMaxRadius = curvature / getMinPc();
+  startRadius =
+      description.radiusDecreasing ? effectiveMaxRadius : effectiveMinRadius;
+  endRadius =
+      description.radiusDecreasing ? effectiveMinRadius : effectiveMaxRadius;
+  linearRadiusStep = (effectiveMaxRadius - effectiveMinRadius) /
+                     userInput::get().twoPhaseSimulationSteps;
+  radiusStep = linearRadiusStep;
+  radiusRatio =
+      std::pow(endRadius / startRadius,
+               1. / userInput::get().twoPhaseSimulationSteps);
+  currentRadius = userInput::get().pcSteppingMode == pcStepping::logSpaced
+                      ? startRadius * radiusRatio
+                      : description.radiusDecreasing ? startRadius - radiusStep
+                                                     : startRadius + radiusStep;
+  currentPc = description.pcFactor * userInput::get().OWSurfaceTension /
+              currentRadius;
+
+  // Pc increases when |Pc| grows for positive Pc or shrinks for negative Pc
+  auto direction = description.radiusDecreasing == (description.pcFactor > 0)
+                       ? invasionFrontier::direction::increasingPc
+                       : invasionFrontier::direction::decreasingPc;
+  snapOffFrontier.initialise(
+      network, direction, [this](element *e) { return getSnapOffPressure(e); });
+  bulkFrontier.initialise(network, direction,
+                          [this](element *e) { return getEntryPressure(e); });
+  pnmOperation::get(network).countOilNeighboors();
+  seedFrontiers();
+
+  initialiseVolumes();
+  previousSw = waterVolume / network->totalNetworkVolume;
+}
+
+void quasiStaticSimulation::insertCandidate(element *e) {
+  if (description.snapOff) snapOffFrontier.insert(e);
+  bulkFrontier.insert(e);
+}
+
+void quasiStaticSimulation::invadeCapillariesAtCurrentPc() {
+  MEASURE_FUNCTION();
+  if (description.snapOff) invadeCapillariesViaSnapOff();
+  invadeCapillariesViaBulk();
+}
+
+void quasiStaticSimulation::invadeCapillariesViaSnapOff() {
+  clusterElements();
+
+  snapOffFrontier.advance(currentPc);
+  invade(snapOffFrontier.selectReady(
+      [this](element *e) { return isInvadableViaSnapOff(e); }));
+
+  updateOutputFiles();
+  updateGUI();
+}
+
+void quasiStaticSimulation::invadeCapillariesViaBulk() {
+  bool stillMore = true;
+  while (stillMore) {
+    clusterElements();
+
+    bulkFrontier.advance(currentPc);
+    std::vector<element *> invadedElements = bulkFrontier.selectReady(
+        [this](element *e) { return isInvadable(e); });
+    invade(invadedElements);
+    stillMore = !invadedElements.empty();
+
+    updateOutputFiles();
+    checkTerminationCondition();
+    updateGUI();
+
+    if (simulationInterrupted) break;
+  }
+}
+
+void quasiStaticSimulation::invade(const std::vector<element *> &elements) {
+  for (element *e : elements) {
+    phase previous = e->getPhaseFlag();
+    fill(e);
+    changedElements.push_back(e);
+    snapOffFrontier.erase(e);
+    bulkFrontier.erase(e);
+    if (e->getType() == capillaryType::throat &&
+        e->getPhaseFlag() != previous)
+      updateOilNeighboors(e, previous);
+    updateFrontiers(e);
+  }
+}
+
+// Pore-body filling thresholds depend on the number of oil-filled throats
+// around the node: the nodes of a throat that changed phase are re-queued
+void quasiStaticSimulation::updateOilNeighboors(element *throat,
+                                                phase previous) {
+  pnmOperation::get(network).updateOilNeighboors(throat, previous);
+  for (element *n : throat->getNeighboors()) bulkFrontier.update(n);
+}
+
+void quasiStaticSimulation::dismissTrappedElements() {
+  MEASURE_FUNCTION();
+  auto isTrappedElement = [this](element *e) { return isTrapped(e); };
+  if (description.snapOff) snapOffFrontier.removeIf(isTrappedElement);
+  bulkFrontier.removeIf(isTrappedElement);
+}
+
+void quasiStaticSimulation::initialiseVolumes() {
+  int size = network->totalNodes + network->totalPores;
+  waterVolumes.assign(size, 0);
+  filmVolumeCoefficients.assign(size, 0);
+  filmMembers.assign(size, false);
+  filmElements.clear();
+  changedElements.clear();
+  waterVolume = 0;
+
+  for (element *e : pnmRange<element>(network)) {
+    int i = index(e);
+    filmVolumeCoefficients[i] = e->getFilmAreaCoefficient() * e->getLength();
+    waterVolumes[i] = getWaterVolume(e);
+    waterVolume += waterVolumes[i];
+    if (carriesFilm(e)) {
+      filmMembers[i] = true;
+      filmElements.push_back(e);
+    }
+  }
+}
+
+void quasiStaticSimulation::updateCapillaryVolumes() {
+  MEASURE_FUNCTION();
+  double radius = userInput::get().OWSurfaceTension / currentPc;
+  filmRadiusSquared = radius * radius;
+
+  for (element *e : changedElements) {
+    if (!filmMembers[index(e)] && carriesFilm(e)) {
+      filmMembers[index(e)] = true;
+      filmElements.push_back(e);
+    }
+    updateWaterVolume(e);
+  }
+  changedElements.clear();
+
+  filmElements.erase(std::remove_if(filmElements.begin(), filmElements.end(),
+                                    [this](element *e) {
+                                      if (carriesFilm(e)) return false;
+                                      filmMembers[index(e)] = false;
+                                      return true;
+                                    }),
+                     filmElements.end());
+
+  for (element *e : filmElements)
+    if (isFilmConnected(e)) {
+      adjustVolumetrics(e);
+      updateWaterVolume(e);
+    }
+
+  currentSw = waterVolume / network->totalNetworkVolume;
+}
+
+void quasiStaticSimulation::updateWaterVolume(element *e) {
+  double &elementVolume = waterVolumes[index(e)];
+  double newVolume = getWaterVolume(e);
+  waterVolume += newVolume - elementVolume;
+  elementVolume = newVolume;
+}
+
+double quasiStaticSimulation::getWaterVolume(element *e) const {
+  if (e->getPhaseFlag() == phase::oil) return e->getWaterFilmVolume();
+
+  if (e->getWettabilityFlag() == wettability::oilWet)
+    return e->getEffectiveVolume() + e->getWaterFilmVolume();
+
+  return e->getVolume();
+}
+
+int quasiStaticSimulation::index(element *e) const {
+  return e->getType() == capillaryType::throat
+             ? network->totalNodes + e->getId() - 1
+             : e->getId() - 1;
+}
+
+void quasiStaticSimulation::updateVariables() {
+  if (userInput::get().pcSteppingMode == pcStepping::adaptive) {
+    updateVariablesAdaptively();
+    return;
+  }
+
+  step++;
+
+  if (step != userInput::get().twoPhaseSimulationSteps) {
+    if (userInput::get().pcSteppingMode == pcStepping::logSpaced)
+      currentRadius *= radiusRatio;
+    else
+      currentRadius += description.radiusDecreasing ? -radiusStep : radiusStep;
+    currentPc = description.pcFactor * userInput::get().OWSurfaceTension /
+                currentRadius;
+  }
+}
+
+// The radius step is halved, down to a sixteenth of the linear step, after a
+// step that changed Sw by more than FluidInjection_SS.maxSwChangePerStep, and
+// grows back once Sw settles. When no threshold of the frontiers lies before
+// the next Pc, Pc jumps to the closest one instead of sweeping a range where
+// nothing can be invaded. step counts the linear steps covered so far.
+void quasiStaticSimulation::updateVariablesAdaptively() {
+  int steps = userInput::get().twoPhaseSimulationSteps;
+  if (currentRadius == endRadius) {
+    step = steps;
+    return;
+  }
+
+  double maxSwChange = userInput::get().maxSwChangePerStep;
+  double swChange = std::abs(currentSw - previousSw);
+  previousSw = currentSw;
+  if (swChange > maxSwChange)
+    radiusStep = std::max(radiusStep / 2, linearRadiusStep / 16);
+  else if (swChange < maxSwChange / 4)
+    radiusStep = std::min(radiusStep * 2, linearRadiusStep);
+
+  double tension = userInput::get().OWSurfaceTension;
+  double nextRadius =
+      currentRadius + (description.radiusDecreasing ? -radiusStep : radiusStep);
+  double nextPc = description.pcFactor * tension / nextRadius;
+  double endPc = description.pcFactor * tension / endRadius;
+
+  double direction =
+      description.radiusDecreasing == (description.pcFactor > 0) ? 1 : -1;
+  double threshold = bulkFrontier.nextThreshold();
+  if (description.snapOff)
+    threshold = direction > 0
+                    ? std::min(threshold, snapOffFrontier.nextThreshold())
+                    : std::max(threshold, snapOffFrontier.nextThreshold());
+  if (direction * (threshold - nextPc) > 0) nextPc = threshold;
+
+  if (direction * (nextPc - endPc) >= 0) {
+    currentRadius = endRadius;
+    currentPc = endPc;
+    step = steps - 1;
+    return;
+  }
+
+  currentPc = nextPc;
+  currentRadius = description.pcFactor * tension / currentPc;
+  step = std::min<int>(
+      steps - 1, std::abs(currentRadius - startRadius) / linearRadiusStep);
+}
+
+void quasiStaticSimulation::updateOutputFiles() {
+  MEASURE_FUNCTION();
+  if (silent) return;
+
+  std::ofstream file;
+
+  if (curvesOutput.isDue(currentSw)) {
+    file.open(pcFilename, std::ofstream::app);
+    file << currentSw << "\t" << currentPc << std::endl;
+    file.close();
+  }
+
+  // Relative permeabilities need two pressure solves: they have their own
+  // schedule, and only the systems are assembled here while the solves run
+  // in the background
+  if (userInput::get().relativePermeabilitiesCalculation &&
+      relativePermeabilitiesOutput.isDue(currentSw))
+    relativePermeabilities.submit(
+        currentSw, pnmSolver::get(network).captureRelativePermeabilities());
+
+  if (networkStatesOutput.isDue(currentSw)) generateNetworkStateFiles();
+}
+
+void quasiStaticSimulation::generateNetworkStateFiles() {
+  if (!userInput::get().extractDataSS) return;
+
+  pnmOperation::get(network).generateNetworkState(frameCount,
+                                                  description.name);
+  frameCount++;
+}
+
+}  // namespace PNM
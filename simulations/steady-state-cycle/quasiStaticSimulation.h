@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef QUASISTATICSIMULATION_H
+#define QUASISTATICSIMULATION_H
+
+#include "invasionFrontier.h"
+#include "misc/outputSchedule.h"
+#include "relativePermeabilityWorkers.h"
+#include "simulations/simulation.h"
+
+#include <string>
+#include <vector>
+
+namespace PNM {
+class element;
+enum class phase;
+
+// Common driver of the quasi-static processes of the steady-state cycle.
+// Pc = pcFactor * IFT / r is stepped through the effective radius range of
+// the process, linearly, log-spaced or adaptively
+// (FluidInjection_SS.pcSteppingMode); at each step the frontiers are invaded
+// until no candidate qualifies anymore, trapped candidates are dismissed and
+// fluid volumes are updated. Processes only provide the policy hooks:
+// frontier seeding, thresholds, invadability, filling and film volumetrics.
+class quasiStaticSimulation : public simulation {
+ public:
+  virtual void run() override;
+  virtual std::string getNotification() override;
+  virtual int getProgress() override;
+
+ protected:
+  struct processDescription {
+    std::string title;          // GUI notification
+    std::string name;           // network states folder
+    std::string resultsPrefix;  // results files, e.g. "1-primaryDrainage"
+    double pcFactor;            // Pc = pcFactor * IFT / effective radius
+    bool radiusDecreasing;      // effective radius stepped downwards
+    bool snapOff;               // snap-off pass before bulk invasion
+    double initialSw;
+  };
+
+  quasiStaticSimulation(const processDescription &);
+  quasiStaticSimulation(const quasiStaticSimulation &) = delete;
+  quasiStaticSimulation(quasiStaticSimulation &&) = delete;
+  auto operator=(const quasiStaticSimulation &)
+      -> quasiStaticSimulation & = delete;
+  auto operator=(quasiStaticSimulation &&) -> quasiStaticSimulation & = delete;
+
+  // Policy hooks
+  virtual void initialiseCapillaries() {}
+  virtual void finaliseCapillaries() {}
+  virtual double getMinPc() = 0;
+  virtual double getMaxPc() = 0;
+  virtual void seedFrontiers() = 0;
+  virtual void clusterElements();
+  virtual double getEntryPressure(element *);
+  virtual double getSnapOffPressure(element *);
+  virtual bool isInvadable(element *) = 0;
+  virtual bool isInvadableViaSnapOff(element *) { return false; }
+  virtual void fill(element *) = 0;
+  virtual void updateFrontiers(element *) {}
+  virtual bool isTrapped(element *) = 0;
+  virtual bool carriesFilm(element *) { return false; }
+  virtual bool isFilmConnected(element *) { return false; }
+  virtual void adjustVolumetrics(element *) {}
+  virtual void checkTerminationCondition() {}
+  virtual void initialiseOutputFiles();
+
+  void initialiseSimulationAttributes();
+  void insertCandidate(element *);
+  void invadeCapillariesAtCurrentPc();
+  void invadeCapillariesViaSnapOff();
+  void invadeCapillariesViaBulk();
+  void invade(const std::vector<element *> &);
+  void updateOilNeighboors(element *throat, phase previous);
+  void dismissTrappedElements();
+  void initialiseVolumes();
+  void updateCapillaryVolumes();
+  void updateWaterVolume(element *);
+  double getWaterVolume(element *) const;
+  double getFilmVolumeCoefficient(element *e) const {
+    return filmVolumeCoefficients[index(e)];
+  }
+  int index(element *) const;
+  void updateOutputFiles();
+  void generateNetworkStateFiles();
+  void updateVariables();
+  void updateVariablesAdaptively();
+
+  processDescription description;
+  bool silent;  // no output files nor relative permeabilities
+  int step;
+  double startRadius;
+  double endRadius;
+  double linearRadiusStep;
+  double radiusStep;   // current step of the linear and adaptive modes
+  double radiusRatio;  // step of the log-spaced mode
+  double currentRadius;
+  double currentPc;
+  double currentSw;
+  double previousSw;  // Sw before the current step, adaptive mode
+  outputSchedule curvesOutput;
+  outputSchedule relativePermeabilitiesOutput;
+  outputSchedule networkStatesOutput;
+  int frameCount;
+  std::string pcFilename;
+  std::string relPermFilename;
+  relativePermeabilityWorkers relativePermeabilities;
+  invasionFrontier snapOffFrontier;
+  invasionFrontier bulkFrontier;
+
+  // Saturation is kept as a running sum of the water volume of each element:
+  // only invaded elements and elements carrying a connected film are
+  // revisited at each step
+  std::vector<double> waterVolumes;
+  double waterVolume;
+  std::vector<double> filmVolumeCoefficients;  // filmAreaCoefficient * length
+  double filmRadiusSquared;                    // (IFT / Pc)^2
+  std::vector<element *> filmElements;
+  std::vector<char> filmMembers;
+  std::vector<element *> changedElements;
+};
+
+}  // namespace PNM
+
+#endif  // QUASISTATICSIMULATION_H
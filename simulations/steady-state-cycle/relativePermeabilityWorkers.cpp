@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#include "relativePermeabilityWorkers.h"
+
+namespace PNM {
+
+void relativePermeabilityWorkers::start(const std::string &path,
+                                        int workerCount) {
+  finish();
+
+  file.open(path, std::ofstream::app);
+  stopping = false;
+  for (int i = 0; i < workerCount; ++i)
+    workers.emplace_back(&relativePermeabilityWorkers::work, this);
+}
+
+// Submissions wait while every worker already has two systems queued, which
+// bounds the memory held by captured systems
+void relativePermeabilityWorkers::submit(
+    double sw, pnmSolver::relativePermeabilitySystems systems) {
+  std::unique_ptr<evaluation> submitted(new evaluation);
+  submitted->sw = sw;
+  submitted->systems = std::move(systems);
+
+  if (workers.empty()) {
+    submitted->relativePermeabilities =
+        pnmSolver::solveRelativePermeabilities(submitted->systems);
+    submitted->solved = true;
+    std::lock_guard<std::mutex> lock(evaluationsMutex);
+    evaluations.push_back(std::move(submitted));
+    writeSolved();
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(evaluationsMutex);
+  changed.wait(lock,
+               [this] { return pending.size() < 2 * workers.size(); });
+  pending.push_back(submitted.get());
+  evaluations.push_back(std::move(submitted));
+  changed.notify_all();
+}
+
+void relativePermeabilityWorkers::finish() {
+  {
+    std::lock_guard<std::mutex> lock(evaluationsMutex);
+    stopping = true;
+    changed.notify_all();
+  }
+  for (std::thread &worker : workers) worker.join();
+  workers.clear();
+
+  if (file.is_open()) file.close();
+}
+
+void relativePermeabilityWorkers::work() {
+  std::unique_lock<std::mutex> lock(evaluationsMutex);
+  while (true) {
+    changed.wait(lock, [this] { return stopping || !pending.empty(); });
+    if (pending.empty()) return;
+
+    evaluation *claimed = pending.front();
+    pending.pop_front();
+    changed.notify_all();
+
+    lock.unlock();
+    auto relativePermeabilities =
+        pnmSolver::solveRelativePermeabilities(claimed->systems);
+    lock.lock();
+
+    claimed->relativePermeabilities = relativePermeabilities;
+    claimed->solved = true;
+    claimed->systems = pnmSolver::relativePermeabilitySystems();
+    writeSolved();
+  }
+}
+
+// Called with the lock held
+void relativePermeabilityWorkers::writeSolved() {
+  while (!evaluations.empty() && evaluations.front()->solved) {
+    const evaluation &solved = *evaluations.front();
+    file << solved.sw << "\t" << solved.relativePermeabilities.first << "\t"
+         << solved.relativePermeabilities.second << std::endl;
+    evaluations.pop_front();
+  }
+}
+
+}  // namespace PNM
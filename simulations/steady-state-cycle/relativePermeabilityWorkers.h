@@ -0,0 +1,66 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018-2021 Ahmed Hamdi Boujelben
+/// Licence:     MIT
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RELATIVEPERMEABILITYWORKERS_H
+#define RELATIVEPERMEABILITYWORKERS_H
+
+#include "operations/pnmSolver.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PNM {
+
+// Background evaluation of relative permeabilities. The pressure systems are
+// captured on the simulation thread, solved by a pool of workers
+// (FluidInjection_SS.relativePermeabilityWorkers) while invasion goes on, and
+// the results are appended to the file in submission order. Without workers,
+// submissions are solved and written right away.
+class relativePermeabilityWorkers {
+ public:
+  relativePermeabilityWorkers() {}
+  ~relativePermeabilityWorkers() { finish(); }
+  relativePermeabilityWorkers(const relativePermeabilityWorkers &) = delete;
+  relativePermeabilityWorkers(relativePermeabilityWorkers &&) = delete;
+  auto operator=(const relativePermeabilityWorkers &)
+      -> relativePermeabilityWorkers & = delete;
+  auto operator=(relativePermeabilityWorkers &&)
+      -> relativePermeabilityWorkers & = delete;
+
+  void start(const std::string &path, int workers);
+  void submit(double sw, pnmSolver::relativePermeabilitySystems);
+  void finish();
+
+ protected:
+  struct evaluation {
+    double sw;
+    pnmSolver::relativePermeabilitySystems systems;
+    bool solved = false;
+    std::pair<double, double> relativePermeabilities;
+  };
+
+  void work();
+  void writeSolved();
+
+  std::ofstream file;
+  std::vector<std::thread> workers;
+  std::deque<std::unique_ptr<evaluation>> evaluations;  // submission order
+  std::deque<evaluation *> pending;                     // not yet claimed
+  std::mutex evaluationsMutex;
+  std::condition_variable changed;
+  bool stopping = false;
+};
+
+}  // namespace PNM
+
+#endif  // RELATIVEPERMEABILITYWORKERS_H
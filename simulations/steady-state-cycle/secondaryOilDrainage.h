@@ -8,14 +8,12 @@
 #ifndef SECONDARYOILDRAINAGE_H
 #define SECONDARYOILDRAINAGE_H
 
-#include "simulations/simulation.h"
-
-#include <unordered_set>
+#include "quasiStaticSimulation.h"
 
 namespace PNM {
 class element;
 
-class secondaryOilDrainage : public simulation {
+class secondaryOilDrainage : public quasiStaticSimulation {
  public:
   secondaryOilDrainage();
   ~secondaryOilDrainage() override;
@@ -25,40 +23,17 @@ class secondaryOilDrainage : public simulation {
       -> secondaryOilDrainage & = delete;
   auto operator=(secondaryOilDrainage &&) -> secondaryOilDrainage & = delete;
 
-  virtual void run() override;
-  virtual std::string getNotification() override;
-  virtual int getProgress() override;
-
  private:
-  void initialiseOutputFiles();
-  void initialiseSimulationAttributes();
-  void initialiseCapillaries();
-  double getMinPc();
-  double getMaxPc();
-  void invadeCapillariesAtCurrentPc();
-  void invadeCapillariesViaSnapOff();
-  void invadeCapillariesViaBulk();
-  void dismissTrappedElements();
-  void adjustCapillaryVolumes();
-  bool isInvadableViaSnapOff(element *);
-  bool isInvadable(element *);
+  double getMinPc() override;
+  double getMaxPc() override;
+  void seedFrontiers() override;
+  bool isInvadable(element *) override;
   bool isConnectedToInletCluster(element *);
-  void fillWithOil(element *);
-  void adjustVolumetrics(element *);
-  void updateOutputFiles();
-  void generateNetworkStateFiles();
-  void updateVariables();
-
-  int step;
-  double radiusStep;
-  double currentRadius;
-  double currentPc;
-  double currentSw;
-  double outputCounter;
-  int frameCount;
-  std::string pcFilename;
-  std::string relPermFilename;
-  std::unordered_set<element *> elementsToInvade;
+  void fill(element *) override;
+  bool isTrapped(element *) override;
+  bool carriesFilm(element *) override;
+  bool isFilmConnected(element *) override;
+  void adjustVolumetrics(element *) override;
 };
 
 }  // namespace PNM
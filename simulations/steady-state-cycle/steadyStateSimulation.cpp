@@ -65,9 +65,16 @@ void steadyStateSimulation::interrupt() {
 
 void steadyStateSimulation::runCurrentSimulation() {
   currentSimulation->setNetwork(network);
-  connect(currentSimulation.get(), SIGNAL(notifyGUI()), this,
-          SLOT(updateGUI()));
+  if (receivers(SIGNAL(notifyGUI())) > 0)
+    connect(currentSimulation.get(), SIGNAL(notifyGUI()), this,
+            SLOT(forwardSnapshot()));
   currentSimulation->execute();
 }
 
+// The current process already throttles and captures its snapshots, they
+// only need to be republished for the GUI.
+void steadyStateSimulation::forwardSnapshot() {
+  publishSnapshot(currentSimulation->getSnapshot());
+}
+
 }  // namespace PNM
@@ -29,6 +29,9 @@ class steadyStateSimulation : public simulation {
   virtual int getProgress() override;
   virtual void interrupt() override;
 
+ private slots:
+  void forwardSnapshot();
+
  private:
   void runCurrentSimulation();
   std::shared_ptr<simulation> currentSimulation;
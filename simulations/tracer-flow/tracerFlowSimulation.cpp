@@ -6,6 +6,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "tracerFlowSimulation.h"
+#include "misc/checkpoint.h"
 #include "misc/tools.h"
 #include "misc/userInput.h"
 #include "network/cluster.h"
@@ -27,9 +28,13 @@ tracerFlowSimulation::tracerFlowSimulation() {}
 tracerFlowSimulation::~tracerFlowSimulation() {}
 
 void tracerFlowSimulation::run() {
-  initialiseOutputFiles();
-  initialiseCapillaries();
-  initialiseSimulationAttributes();
+  checkpoint runCheckpoint("Tracer_Simulation");
+
+  if (!restoreCheckpoint(runCheckpoint)) {
+    initialiseOutputFiles();
+    initialiseCapillaries();
+    initialiseSimulationAttributes();
+  }
 
   fetchNonFlowingCapillaries();
   solvePressureField();
@@ -41,6 +46,8 @@ void tracerFlowSimulation::run() {
     updateOutputFiles();
     updateGUI();
 
+    if (runCheckpoint.isDue()) saveCheckpoint(runCheckpoint);
+
     if (simulationInterrupted) break;
   }
 }
@@ -59,8 +66,9 @@ int tracerFlowSimulation::getProgress() {
 }
 
 void tracerFlowSimulation::initialiseOutputFiles() {
-  tools::initialiseFolder("Results/Tracer_Simulation");
-  tools::initialiseFolder("Network_State/Tracer_Simulation");
+  tools::initialiseFolder(tools::outputPath("Results/Tracer_Simulation"));
+  tools::initialiseFolder(
+      tools::outputPath("Network_State/Tracer_Simulation"));
 }
 
 void tracerFlowSimulation::initialiseSimulationAttributes() {
@@ -73,7 +81,7 @@ void tracerFlowSimulation::initialiseSimulationAttributes() {
   timeSoFar = 0;
   injectedPVs = 0;
 
-  outputCounter = 0;
+  networkStatesOutput.initialise(userInput::get().networkStatesOutput);
   frameCount = 0;
 
   auto inletFlux = userInput::get().flowRate / network->inletPoresArea;
@@ -82,6 +90,7 @@ void tracerFlowSimulation::initialiseSimulationAttributes() {
 
 void tracerFlowSimulation::initialiseCapillaries() {
   pnmOperation::get(network).setSwi();
+  pnmOperation::get(network).releaseFilmAttributes();
   setInitialAttributes();
 }
 
@@ -297,11 +306,7 @@ void tracerFlowSimulation::updateVariables() {
 }
 
 void tracerFlowSimulation::updateOutputFiles() {
-  if (std::abs(outputCounter - injectedPVs) < 0.01) return;
-
-  generateNetworkStateFiles();
-
-  outputCounter = injectedPVs;
+  if (networkStatesOutput.isDue(injectedPVs)) generateNetworkStateFiles();
 }
 
 void tracerFlowSimulation::generateNetworkStateFiles() {
@@ -312,4 +317,32 @@ void tracerFlowSimulation::generateNetworkStateFiles() {
   frameCount++;
 }
 
+void tracerFlowSimulation::saveCheckpoint(checkpoint &runCheckpoint) {
+  checkpointVariables variables;
+  variables.timeSoFar = timeSoFar;
+  variables.injectedPVs = injectedPVs;
+  variables.networkStatesOutput = networkStatesOutput.getState();
+  variables.frameCount = frameCount;
+
+  runCheckpoint.save(network, variables);
+}
+
+bool tracerFlowSimulation::restoreCheckpoint(checkpoint &runCheckpoint) {
+  if (!userInput::get().restartFromCheckpoint) return false;
+
+  checkpointVariables variables;
+  if (!runCheckpoint.restore(network, variables)) return false;
+
+  // The phases don't change during a tracer run: the flow field and the time
+  // step are recalculated identically from the restored state
+  initialiseSimulationAttributes();
+
+  timeSoFar = variables.timeSoFar;
+  injectedPVs = variables.injectedPVs;
+  networkStatesOutput.setState(variables.networkStatesOutput);
+  frameCount = variables.frameCount;
+
+  return true;
+}
+
 }  // namespace PNM
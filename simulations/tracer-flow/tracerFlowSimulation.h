@@ -8,10 +8,13 @@
 #ifndef TRACERFLOWSIMULATION_H
 #define TRACERFLOWSIMULATION_H
 
+#include "misc/outputSchedule.h"
 #include "simulations/simulation.h"
 
 namespace PNM {
 
+class checkpoint;
+
 class tracerFlowSimulation : public simulation {
  public:
   tracerFlowSimulation();
@@ -38,13 +41,15 @@ class tracerFlowSimulation : public simulation {
   void updateVariables();
   void updateOutputFiles();
   void generateNetworkStateFiles();
+  void saveCheckpoint(checkpoint &);
+  bool restoreCheckpoint(checkpoint &);
 
   double simulationTime;
   double timeSoFar;
   double timeStep;
   double injectedPVs;
   double flowVelocity;
-  double outputCounter;
+  outputSchedule networkStatesOutput;
   int frameCount;
 };
 
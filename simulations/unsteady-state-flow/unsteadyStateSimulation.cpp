@@ -6,7 +6,9 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "unsteadyStateSimulation.h"
+#include "misc/checkpoint.h"
 #include "misc/maths.h"
+#include "misc/parallel.h"
 #include "misc/scopedtimer.h"
 #include "misc/tools.h"
 #include "misc/userInput.h"
@@ -16,23 +18,63 @@
 #include "operations/pnmOperation.h"
 #include "operations/pnmSolver.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <vector>
 
 namespace PNM {
 
+namespace {
+// An element is filled once its water fraction is within this of 1. The
+// fractions are stored as storageReal: in single precision, 1 - 1e-8 rounds
+// to 1 and increments that small are lost, so the tolerance is kept a few
+// rounding steps away from 1.
+const double fillTolerance =
+    std::max(1e-8, 4. * std::numeric_limits<storageReal>::epsilon());
+
+template <typename T>
+void writeValues(std::ostream &out, const std::vector<T> &values) {
+  uint64_t size = values.size();
+  out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  out.write(reinterpret_cast<const char *>(values.data()), size * sizeof(T));
+}
+
+template <typename T>
+bool readValues(std::istream &in, std::vector<T> &values, size_t maxSize) {
+  uint64_t size(0);
+  in.read(reinterpret_cast<char *>(&size), sizeof(size));
+  if (!in || size > maxSize) return false;
+  values.resize(size);
+  in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+  return static_cast<bool>(in);
+}
+
+struct frontTotals {
+  double totalFrontFlow;
+  unsigned solveCount;
+  int fillingEventsSinceSolve;
+  double filledFlowSinceSolve;
+};
+}  // namespace
+
 unsteadyStateSimulation::unsteadyStateSimulation() {}
 
 unsteadyStateSimulation::~unsteadyStateSimulation() {}
 
 void unsteadyStateSimulation::run() {
-  initialiseOutputFiles();
-  initialiseCapillaries();
-  initialiseSimulationAttributes();
+  checkpoint runCheckpoint("USS_Simulation");
+
+  if (!restoreCheckpoint(runCheckpoint)) {
+    initialiseOutputFiles();
+    initialiseCapillaries();
+    initialiseSimulationAttributes();
+  }
 
   while (!simulationInterrupted && timeSoFar < simulationTime) {
     fetchTrappedCapillaries();
@@ -46,8 +88,24 @@ void unsteadyStateSimulation::run() {
     updateOutputFiles();
     updateGUI();
 
+    if (runCheckpoint.isDue()) saveCheckpoint(runCheckpoint);
+
     if (simulationInterrupted) break;
   }
+
+  if (eventDriven) updateFrontFractions();
+
+  saturationsFile.close();
+  fractionalFlowsFile.close();
+  pressureFile.close();
+
+  std::ofstream solverFile(
+      tools::outputPath("Results/Profiling/pressureSolver.txt"));
+  solverFile << "Factorizations\tThroat closing passes\tIsolation fallbacks"
+             << "\tIsolation check visits" << std::endl;
+  solverFile << pressureFactorizations << "\t" << pressureActiveSetPasses
+             << "\t" << pressureIsolationFallbacks << "\t"
+             << pressureIsolationVisits << std::endl;
 }
 
 std::string unsteadyStateSimulation::getNotification() {
@@ -65,30 +123,26 @@ int unsteadyStateSimulation::getProgress() {
 }
 
 void unsteadyStateSimulation::initialiseOutputFiles() {
-  tools::initialiseFolder("Results/USS_Simulation");
-  tools::initialiseFolder("Network_State/USS_Simulation");
+  tools::initialiseFolder(tools::outputPath("Results/USS_Simulation"));
+  tools::initialiseFolder(tools::outputPath("Network_State/USS_Simulation"));
 
-  satFilename = "Results/USS_Simulation/saturations.txt";
-  fractionalFilename = "Results/USS_Simulation/fractionalFlows.txt";
-  pressureFilename = "Results/USS_Simulation/deltaP.txt";
-
-  std::ofstream file;
-
-  file.open(satFilename.c_str());
-  file << "injectedPvs\tSw\n";
-  file.close();
-
-  file.open(fractionalFilename.c_str());
-  file << "injectedPvs\tFo\tFw\n";
-  file.close();
+  openOutputFiles(false);
+}
 
-  file.open(pressureFilename.c_str());
-  file << "injectedPvs\tdeltaP(psi)\n";
-  file.close();
+void unsteadyStateSimulation::openOutputFiles(bool append) {
+  std::string resultsFolder = tools::outputPath("Results/USS_Simulation/");
+  saturationsFile.open(resultsFolder + "saturations", {"injectedPvs", "Sw"},
+                       append);
+  fractionalFlowsFile.open(resultsFolder + "fractionalFlows",
+                           {"injectedPvs", "Fo", "Fw"}, append);
+  pressureFile.open(resultsFolder + "deltaP", {"injectedPvs", "deltaP(psi)"},
+                    append);
 }
 
 void unsteadyStateSimulation::initialiseCapillaries() {
   pnmOperation::get(network).setSwi();
+  pnmOperation::get(network).releaseFilmAttributes();
+  pnmOperation::get(network).releaseTracerAttributes();
   addWaterChannel();
   setInitialTerminalFlags();
 }
@@ -102,7 +156,8 @@ void unsteadyStateSimulation::initialiseSimulationAttributes() {
   timeSoFar = 0;
   injectedPVs = 0;
 
-  outputCounter = 0;
+  curvesOutput.initialise(userInput::get().curvesOutput);
+  networkStatesOutput.initialise(userInput::get().networkStatesOutput);
   frameCount = 0;
 
   currentSw = pnmOperation::get(network).getSw();
@@ -112,7 +167,22 @@ void unsteadyStateSimulation::initialiseSimulationAttributes() {
                     userInput::get().OWSurfaceTension;
   flowVelocity = inletFlux * 86400;
 
+  // Conductivities are then only updated where viscosities change
+  pnmOperation::get(network).assignViscosities();
+  pnmOperation::get(network).assignConductivities();
+
   updatePressureCalculation = true;
+  pressureFactorizations = 0;
+  pressureActiveSetPasses = 0;
+  pressureIsolationFallbacks = 0;
+  pressureIsolationVisits = 0;
+
+  poresToCheck.initialise(network);
+  nodesToCheck.initialise(network);
+  unstoredWater.assign(network->totalPores + network->totalNodes, 0);
+  pnmOperation::get(network).countOilNeighboors();
+
+  initialiseFillingEvents();
 }
 
 void unsteadyStateSimulation::addWaterChannel() {
@@ -229,117 +299,136 @@ void unsteadyStateSimulation::updateCapillaryPropreties() {
 
   if (!updatePressureCalculation) return;
 
-  pnmOperation::get(network).assignViscosities();
-  pnmOperation::get(network).assignConductivities();
+  if (eventDriven) updateFrontFractions();
+
+  pnmOperation::get(network).updateConductivities();
 
   poresToCheck.clear();
   nodesToCheck.clear();
 
-  for (node *p : pnmRange<node>(network)) {
-    p->setActive(true);
+  parallel::forChunks(network->totalNodes, [this](int begin, int end, int) {
+    for (int i = begin; i < end; ++i) {
+      node *p = network->getNode(i);
+      p->setActive(true);
 
-    if (p->getPhaseFlag() == phase::oil && p->getOilTrapped())
-      p->setActive(false);
+      if (p->getPhaseFlag() == phase::oil && p->getOilTrapped())
+        p->setActive(false);
 
-    if (p->getPhaseFlag() == phase::water && p->getWaterTrapped())
-      p->setActive(false);
+      if (p->getPhaseFlag() == phase::water && p->getWaterTrapped())
+        p->setActive(false);
+    }
+  });
+
+  // Pores are processed in parallel, the interface elements found by each
+  // chunk are added to the sets afterwards in network order
+  int chunks = parallel::chunkCount(network->totalPores);
+  std::vector<std::vector<pore *>> poresFound(chunks);
+  std::vector<std::vector<node *>> nodesFound(chunks);
+
+  parallel::forChunks(network->totalPores, [&](int begin, int end, int chunk) {
+    for (int i = begin; i < end; ++i)
+      updatePoreCapillaryPropreties(network->getPore(i), poresFound[chunk],
+                                    nodesFound[chunk]);
+  });
+
+  for (int chunk = 0; chunk < chunks; ++chunk) {
+    for (pore *p : poresFound[chunk]) poresToCheck.insert(p);
+    for (node *n : nodesFound[chunk]) nodesToCheck.insert(n);
   }
+}
 
-  for (pore *p : pnmRange<pore>(network)) {
-    p->setActive(true);
-    p->setCapillaryPressure(0);
+void unsteadyStateSimulation::updatePoreCapillaryPropreties(
+    pore *p, std::vector<pore *> &poresFound,
+    std::vector<node *> &nodesFound) {
+  p->setActive(true);
+  p->setCapillaryPressure(0);
 
-    if (p->getPhaseFlag() == phase::oil) {
-      if (p->getOilTrapped())
-        p->setActive(false);
-      else {
-        // Determine pores to check for phase changes
-        if ((p->getNodeIn() != nullptr &&
-             p->getNodeIn()->getPhaseFlag() == phase::water &&
-             !p->getNodeIn()->getWaterTrapped()) ||
-            (p->getNodeOut() != nullptr &&
-             p->getNodeOut()->getPhaseFlag() == phase::water &&
-             !p->getNodeOut()->getWaterTrapped()))
-          poresToCheck.insert(p);
-
-        // Update capilary pressures a pores with an oil/water interface
-        if (!p->getInlet() && !p->getOutlet() && p->getNodeIn() != nullptr &&
-            p->getNodeOut() != nullptr) {
-          if (p->getNodeOut()->getPhaseFlag() == phase::oil &&
-              p->getNodeIn()->getPhaseFlag() == phase::water)
-            p->setCapillaryPressure(p->getEntryPressureCoefficient() *
-                                    userInput::get().OWSurfaceTension *
-                                    cos(p->getTheta()) / p->getRadius());
-        }
-        if (!p->getInlet() && !p->getOutlet() && p->getNodeIn() != nullptr &&
-            p->getNodeOut() != nullptr) {
-          if (p->getNodeOut()->getPhaseFlag() == phase::water &&
-              p->getNodeIn()->getPhaseFlag() == phase::oil)
-            p->setCapillaryPressure(-p->getEntryPressureCoefficient() *
-                                    userInput::get().OWSurfaceTension *
-                                    cos(p->getTheta()) / p->getRadius());
-        }
+  if (p->getPhaseFlag() == phase::oil) {
+    if (p->getOilTrapped())
+      p->setActive(false);
+    else {
+      // Determine pores to check for phase changes
+      if ((p->getNodeIn() != nullptr &&
+           p->getNodeIn()->getPhaseFlag() == phase::water &&
+           !p->getNodeIn()->getWaterTrapped()) ||
+          (p->getNodeOut() != nullptr &&
+           p->getNodeOut()->getPhaseFlag() == phase::water &&
+           !p->getNodeOut()->getWaterTrapped()))
+        poresFound.push_back(p);
+
+      // Update capilary pressures a pores with an oil/water interface
+      if (!p->getInlet() && !p->getOutlet() && p->getNodeIn() != nullptr &&
+          p->getNodeOut() != nullptr) {
+        if (p->getNodeOut()->getPhaseFlag() == phase::oil &&
+            p->getNodeIn()->getPhaseFlag() == phase::water)
+          p->setCapillaryPressure(p->getEntryPressureCoefficient() *
+                                  userInput::get().OWSurfaceTension *
+                                  cos(p->getTheta()) / p->getRadius());
+      }
+      if (!p->getInlet() && !p->getOutlet() && p->getNodeIn() != nullptr &&
+          p->getNodeOut() != nullptr) {
+        if (p->getNodeOut()->getPhaseFlag() == phase::water &&
+            p->getNodeIn()->getPhaseFlag() == phase::oil)
+          p->setCapillaryPressure(-p->getEntryPressureCoefficient() *
+                                  userInput::get().OWSurfaceTension *
+                                  cos(p->getTheta()) / p->getRadius());
       }
     }
+  }
 
-    if (p->getPhaseFlag() == phase::water) {
-      if (p->getWaterTrapped())
-        p->setActive(false);
-      else {
-        // Determine nodes to check for phase changes
-        node *nodeIn = p->getNodeIn();
-        node *nodeOut = p->getNodeOut();
-        if (nodeIn != nullptr && nodeIn->getPhaseFlag() == phase::oil &&
-            !nodeIn->getOilTrapped())
-          nodesToCheck.insert(nodeIn);
-        if (nodeOut != nullptr && nodeOut->getPhaseFlag() == phase::oil &&
-            !nodeOut->getOilTrapped())
-          nodesToCheck.insert(nodeOut);
-
-        // Update capilary pressures a nodes with an oil/water interfac
-        if (!p->getInlet() && !p->getOutlet() && nodeIn != nullptr &&
-            nodeOut != nullptr) {
-          if (nodeOut->getPhaseFlag() == phase::oil &&
-              nodeIn->getPhaseFlag() == phase::water) {
-            // pore filling mechanism
-            int oilNeighboorsNumber(0);
-            for (element *n : nodeOut->getNeighboors())
-              if (n->getPhaseFlag() == phase::oil) oilNeighboorsNumber++;
-
-            if (nodeOut->getTheta() > maths::pi() / 2)  // drainage
-              p->setCapillaryPressure(nodeOut->getEntryPressureCoefficient() *
-                                      userInput::get().OWSurfaceTension *
-                                      cos(nodeOut->getTheta()) /
-                                      nodeOut->getRadius());
-            if (nodeOut->getTheta() < maths::pi() / 2)  // imbibition
-              p->setCapillaryPressure(
-                  nodeOut->getEntryPressureCoefficient() *
-                      userInput::get().OWSurfaceTension *
-                      cos(nodeOut->getTheta()) / nodeOut->getRadius() -
-                  oilNeighboorsNumber * userInput::get().OWSurfaceTension /
-                      nodeOut->getRadius());
-          }
+  if (p->getPhaseFlag() == phase::water) {
+    if (p->getWaterTrapped())
+      p->setActive(false);
+    else {
+      // Determine nodes to check for phase changes
+      node *nodeIn = p->getNodeIn();
+      node *nodeOut = p->getNodeOut();
+      if (nodeIn != nullptr && nodeIn->getPhaseFlag() == phase::oil &&
+          !nodeIn->getOilTrapped())
+        nodesFound.push_back(nodeIn);
+      if (nodeOut != nullptr && nodeOut->getPhaseFlag() == phase::oil &&
+          !nodeOut->getOilTrapped())
+        nodesFound.push_back(nodeOut);
+
+      // Update capilary pressures a nodes with an oil/water interfac
+      if (!p->getInlet() && !p->getOutlet() && nodeIn != nullptr &&
+          nodeOut != nullptr) {
+        if (nodeOut->getPhaseFlag() == phase::oil &&
+            nodeIn->getPhaseFlag() == phase::water) {
+          // pore filling mechanism
+          int oilNeighboorsNumber = nodeOut->getOilNeighboors();
+
+          if (nodeOut->getTheta() > maths::pi() / 2)  // drainage
+            p->setCapillaryPressure(nodeOut->getEntryPressureCoefficient() *
+                                    userInput::get().OWSurfaceTension *
+                                    cos(nodeOut->getTheta()) /
+                                    nodeOut->getRadius());
+          if (nodeOut->getTheta() < maths::pi() / 2)  // imbibition
+            p->setCapillaryPressure(
+                nodeOut->getEntryPressureCoefficient() *
+                    userInput::get().OWSurfaceTension *
+                    cos(nodeOut->getTheta()) / nodeOut->getRadius() -
+                oilNeighboorsNumber * userInput::get().OWSurfaceTension /
+                    nodeOut->getRadius());
+        }
 
-          if (nodeOut->getPhaseFlag() == phase::water &&
-              nodeIn->getPhaseFlag() == phase::oil) {
-            // pore filling mechanism
-            int oilNeighboorsNumber(0);
-            for (element *n : nodeIn->getNeighboors())
-              if (n->getPhaseFlag() == phase::oil) oilNeighboorsNumber++;
-
-            if (nodeIn->getTheta() > maths::pi() / 2)  // drainage
-              p->setCapillaryPressure(-nodeIn->getEntryPressureCoefficient() *
-                                      userInput::get().OWSurfaceTension *
-                                      cos(nodeIn->getTheta()) /
-                                      nodeIn->getRadius());
-            if (nodeIn->getTheta() < maths::pi() / 2)  // imbibition
-              p->setCapillaryPressure(
-                  -nodeIn->getEntryPressureCoefficient() *
-                      userInput::get().OWSurfaceTension *
-                      cos(nodeIn->getTheta()) / nodeIn->getRadius() +
-                  oilNeighboorsNumber * userInput::get().OWSurfaceTension /
-                      nodeIn->getRadius());
-          }
+        if (nodeOut->getPhaseFlag() == phase::water &&
+            nodeIn->getPhaseFlag() == phase::oil) {
+          // pore filling mechanism
+          int oilNeighboorsNumber = nodeIn->getOilNeighboors();
+
+          if (nodeIn->getTheta() > maths::pi() / 2)  // drainage
+            p->setCapillaryPressure(-nodeIn->getEntryPressureCoefficient() *
+                                    userInput::get().OWSurfaceTension *
+                                    cos(nodeIn->getTheta()) /
+                                    nodeIn->getRadius());
+          if (nodeIn->getTheta() < maths::pi() / 2)  // imbibition
+            p->setCapillaryPressure(
+                -nodeIn->getEntryPressureCoefficient() *
+                    userInput::get().OWSurfaceTension *
+                    cos(nodeIn->getTheta()) / nodeIn->getRadius() +
+                oilNeighboorsNumber * userInput::get().OWSurfaceTension /
+                    nodeIn->getRadius());
         }
       }
     }
@@ -351,6 +440,29 @@ void unsteadyStateSimulation::solvePressureField() {
 
   if (!updatePressureCalculation) return;
 
+  // Throats whose flow would push oil into a water-filled node, or make oil
+  // flow back through an outlet, are closed and the pressures recalculated
+  auto mustClose = [](pore *p) {
+    if (p->getNodeIn() != nullptr && p->getNodeOut() != nullptr &&
+        ((p->getFlow() > 0 && p->getNodeOut()->getPhaseFlag() == phase::oil &&
+          p->getNodeIn()->getWaterFraction() > 1e-20) ||
+         (p->getFlow() < 0 && p->getNodeOut()->getWaterFraction() > 1e-20 &&
+          p->getNodeIn()->getPhaseFlag() == phase::oil)))
+      return true;
+    return p->getOutlet() && p->getFlow() < 0;
+  };
+
+  if (userInput::get().activeSetSolver) {
+    pnmSolver::get(network).solvePressuresConstantFlowRate(mustClose);
+    pressureFactorizations += pnmSolver::get(network).getOuterPasses();
+    pressureActiveSetPasses += pnmSolver::get(network).getActiveSetPasses();
+    pressureIsolationFallbacks +=
+        pnmSolver::get(network).getIsolationFallbacks();
+    pressureIsolationVisits += pnmSolver::get(network).getIsolationVisits();
+    if (eventDriven) updateFillingEvents();
+    return;
+  }
+
   bool stillMorePoresToClose = true;
 
   while (stillMorePoresToClose) {
@@ -365,45 +477,53 @@ void unsteadyStateSimulation::solvePressureField() {
     stillMorePoresToClose = false;
 
     pnmSolver::get(network).solvePressuresConstantFlowRate();
+    ++pressureFactorizations;
 
     for (pore *p : pnmRange<pore>(network)) {
-      if (p->getActive() && p->getNodeIn() != nullptr &&
-          p->getNodeOut() != nullptr &&
-          ((p->getFlow() > 0 && p->getNodeOut()->getPhaseFlag() == phase::oil &&
-            p->getNodeIn()->getWaterFraction() > 1e-20) ||
-           (p->getFlow() < 0 && p->getNodeOut()->getWaterFraction() > 1e-20 &&
-            p->getNodeIn()->getPhaseFlag() == phase::oil))) {
-        p->setCapillaryPressure(0);
-        p->setActive(false);
-        stillMorePoresToClose = true;
-      }
-      if (p->getActive() && p->getOutlet() && p->getFlow() < 0) {
+      if (p->getActive() && mustClose(p)) {
         p->setCapillaryPressure(0);
         p->setActive(false);
         stillMorePoresToClose = true;
       }
     }
+    if (stillMorePoresToClose) ++pressureActiveSetPasses;
   }
+
+  if (eventDriven) updateFillingEvents();
 }
 
 void unsteadyStateSimulation::calculateTimeStep() {
   // MEASURE_FUNCTION(); //Profiling
 
   timeStep = 1e50;
-  for (pore *p : poresToCheck) {
-    if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
-      double step =
-          p->getVolume() * p->getOilFraction() / std::abs(p->getFlow());
-      if (step < timeStep) timeStep = step;
-    }
-  }
 
-  for (node *p : nodesToCheck) {
-    if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
-      double step =
-          p->getVolume() * p->getOilFraction() / std::abs(p->getFlow());
-      if (step < timeStep) timeStep = step;
-    }
+  if (eventDriven) {
+    double nextFillingTime = getNextFillingTime();
+    if (nextFillingTime < 1e50)
+      timeStep = std::max(0.0, nextFillingTime - timeSoFar);
+  } else {
+    // Minimum over the interface elements, one partial minimum per chunk
+    auto minimumFillingTime = [this](auto &elements) {
+      auto first = elements.begin();
+      int size = elements.size();
+      std::vector<double> steps(parallel::chunkCount(size), 1e50);
+      parallel::forChunks(size, [&](int begin, int end, int chunk) {
+        double minStep = 1e50;
+        for (int i = begin; i < end; ++i) {
+          element *p = first[i];
+          if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
+            double step =
+                p->getVolume() * p->getOilFraction() / std::abs(p->getFlow());
+            if (step < minStep) minStep = step;
+          }
+        }
+        steps[chunk] = minStep;
+      });
+      return *std::min_element(steps.begin(), steps.end());
+    };
+
+    timeStep = std::min(minimumFillingTime(poresToCheck),
+                        minimumFillingTime(nodesToCheck));
   }
 
   if (hkClustering::get(network)
@@ -418,41 +538,66 @@ void unsteadyStateSimulation::calculateTimeStep() {
 void unsteadyStateSimulation::updateFluidFractions() {
   // MEASURE_FUNCTION(); //Profiling
 
-  for (pore *p : poresToCheck) {
-    if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
-      double incrementalWater = std::abs(p->getFlow()) * timeStep;
-      currentSw += incrementalWater / network->totalNetworkVolume;
-
-      p->setWaterFraction(p->getWaterFraction() +
-                          incrementalWater / p->getVolume());
-      p->setOilFraction(1 - p->getWaterFraction());
-
-      if (p->getWaterFraction() > 1 - 1e-8) {
-        p->setPhaseFlag(phase::water);
-        p->setWaterFraction(1);
-        p->setOilFraction(0);
-        updatePressureCalculation = true;
-      }
-    }
+  if (eventDriven) {
+    processFillingEvents();
+    return;
   }
 
-  for (node *p : nodesToCheck) {
-    if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
-      double incrementalWater = std::abs(p->getFlow()) * timeStep;
-      currentSw += incrementalWater / network->totalNetworkVolume;
-
-      p->setWaterFraction(p->getWaterFraction() +
-                          incrementalWater / p->getVolume());
-      p->setOilFraction(1 - p->getWaterFraction());
-
-      if (p->getWaterFraction() > 1 - 1e-8) {
-        p->setPhaseFlag(phase::water);
-        p->setWaterFraction(1);
-        p->setOilFraction(0);
-        updatePressureCalculation = true;
+  // The interface elements are filled in parallel: each chunk sums the water
+  // it injected and records the oil elements it filled, and the partial
+  // results are combined in chunk order
+  auto fillElements = [this](auto &elements) {
+    auto first = elements.begin();
+    int size = elements.size();
+    int chunks = parallel::chunkCount(size);
+    std::vector<double> injectedWater(chunks, 0);
+    std::vector<char> elementsFilled(chunks, false);
+    std::vector<std::vector<element *>> oilElementsFilled(chunks);
+
+    parallel::forChunks(size, [&](int begin, int end, int chunk) {
+      double chunkWater(0);
+      bool chunkFilled(false);
+      for (int i = begin; i < end; ++i) {
+        element *p = first[i];
+        if (p->getActive() && std::abs(p->getFlow()) > 1e-50) {
+          double incrementalWater = std::abs(p->getFlow()) * timeStep;
+          chunkWater += incrementalWater / network->totalNetworkVolume;
+
+          // The water the stored fraction could not take is added back with
+          // the next increment
+          double &unstored = unstoredWater[getFrontIndex(p)];
+          double waterFraction = p->getWaterFraction() +
+                                 (incrementalWater + unstored) / p->getVolume();
+          p->setWaterFraction(waterFraction);
+          p->setOilFraction(1 - p->getWaterFraction());
+          unstored = (waterFraction - p->getWaterFraction()) * p->getVolume();
+
+          if (p->getWaterFraction() > 1 - fillTolerance) {
+            if (p->getPhaseFlag() == phase::oil)
+              oilElementsFilled[chunk].push_back(p);
+            p->setPhaseFlag(phase::water);
+            p->setWaterFraction(1);
+            p->setOilFraction(0);
+            unstored = 0;
+            chunkFilled = true;
+          }
+        }
       }
+      injectedWater[chunk] = chunkWater;
+      elementsFilled[chunk] = chunkFilled;
+    });
+
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      currentSw += injectedWater[chunk];
+      if (elementsFilled[chunk]) updatePressureCalculation = true;
+      for (element *e : oilElementsFilled[chunk])
+        if (e->getType() == capillaryType::throat)
+          pnmOperation::get(network).updateOilNeighboors(e, phase::oil);
     }
-  }
+  };
+
+  fillElements(poresToCheck);
+  fillElements(nodesToCheck);
 }
 
 void unsteadyStateSimulation::updateFluidTerminalFlags() {
@@ -543,29 +688,331 @@ void unsteadyStateSimulation::updateVariables() {
 }
 
 void unsteadyStateSimulation::updateOutputFiles() {
-  if (std::abs(outputCounter - injectedPVs) < 0.01) return;
+  if (curvesOutput.isDue(injectedPVs)) {
+    saturationsFile.write({injectedPVs, currentSw});
 
-  std::ofstream file;
+    auto Fw = pnmOperation::get(network).getFlow(phase::water) /
+              userInput::get().flowRate;
+    auto Fo = 1 - Fw;
+    fractionalFlowsFile.write({injectedPVs, Fo, Fw});
 
-  file.open(satFilename, std::ofstream::app);
-  file << injectedPVs << "\t" << currentSw << std::endl;
-  file.close();
+    auto deltaP = pnmSolver::get(network).getDeltaP();
+    pressureFile.write({injectedPVs, maths::PaToPsi(deltaP)});
+  }
 
-  auto Fw = pnmOperation::get(network).getFlow(phase::water) /
-            userInput::get().flowRate;
-  auto Fo = 1 - Fw;
-  file.open(fractionalFilename, std::ofstream::app);
-  file << injectedPVs << "\t" << Fo << "\t" << Fw << std::endl;
-  file.close();
+  if (networkStatesOutput.isDue(injectedPVs)) generateNetworkStateFiles();
+}
+
+void unsteadyStateSimulation::saveCheckpoint(checkpoint &runCheckpoint) {
+  // Between two pressure solves, the flows and the front fractions of the
+  // event-driven mode are not part of the network state: wait for the next
+  // iteration that recalculates them
+  if (!updatePressureCalculation) return;
+
+  if (eventDriven) updateFrontFractions();
+
+  checkpointVariables variables;
+  variables.timeSoFar = timeSoFar;
+  variables.injectedPVs = injectedPVs;
+  variables.curvesOutput = curvesOutput.getState();
+  variables.networkStatesOutput = networkStatesOutput.getState();
+  variables.currentSw = currentSw;
+  variables.frameCount = frameCount;
+  variables.fillingEventsBatch = eventDriven ? fillingEventsBatch : 0;
+
+  // The recorded result file sizes must include every record written so far
+  saturationsFile.flush();
+  fractionalFlowsFile.flush();
+  pressureFile.flush();
+
+  runCheckpoint.save(network, variables,
+                     {saturationsFile.getPath(), fractionalFlowsFile.getPath(),
+                      pressureFile.getPath()},
+                     eventDriven ? saveFillingEvents() : std::string());
+}
+
+bool unsteadyStateSimulation::restoreCheckpoint(checkpoint &runCheckpoint) {
+  if (!userInput::get().restartFromCheckpoint) return false;
 
-  auto deltaP = pnmSolver::get(network).getDeltaP();
-  file.open(pressureFilename, std::ofstream::app);
-  file << injectedPVs << "\t" << maths::PaToPsi(deltaP) << std::endl;
-  file.close();
+  checkpointVariables variables;
+  std::string fillingEventsData;
+  if (!runCheckpoint.restore(network, variables, &fillingEventsData))
+    return false;
+
+  openOutputFiles(true);
+  initialiseSimulationAttributes();
 
-  generateNetworkStateFiles();
+  timeSoFar = variables.timeSoFar;
+  injectedPVs = variables.injectedPVs;
+  curvesOutput.setState(variables.curvesOutput);
+  networkStatesOutput.setState(variables.networkStatesOutput);
+  currentSw = variables.currentSw;
+  frameCount = variables.frameCount;
+  if (eventDriven && variables.fillingEventsBatch > 0)
+    fillingEventsBatch = std::min(variables.fillingEventsBatch,
+                                  userInput::get().maxFillingEventsPerSolve);
+
+  // Without them (a checkpoint of a run that was not event-driven), the
+  // events are projected again from the restored flows
+  if (eventDriven && !fillingEventsData.empty() &&
+      !restoreFillingEvents(fillingEventsData))
+    std::cout << "WARNING: The filling events of the checkpoint could not be "
+                 "restored"
+              << std::endl;
+
+  return true;
+}
+
+// The front of the event-driven mode, so that a restarted run projects,
+// batches and fills the elements as the uninterrupted one. Superseded
+// events are left out.
+std::string unsteadyStateSimulation::saveFillingEvents() const {
+  std::vector<fillingEvent> events;
+  auto pending = fillingEvents;
+  for (; !pending.empty(); pending.pop())
+    if (pending.top().version == eventVersions[pending.top().index])
+      events.push_back(pending.top());
+
+  frontTotals totals = {totalFrontFlow, solveCount, fillingEventsSinceSolve,
+                        filledFlowSinceSolve};
+
+  std::ostringstream out;
+  out.write(reinterpret_cast<const char *>(&totals), sizeof(totals));
+  writeValues(out, frontFlows);
+  writeValues(out, frontUpdateTimes);
+  writeValues(out, eventVersions);
+  writeValues(out, frontStamps);
+  writeValues(out, projectedElements);
+  writeValues(out, events);
+  return out.str();
+}
+
+// Leaves the events as initialised if the data doesn't match the network
+bool unsteadyStateSimulation::restoreFillingEvents(const std::string &data) {
+  size_t totalElements = network->totalPores + network->totalNodes;
+  std::istringstream in(data);
+
+  frontTotals totals;
+  in.read(reinterpret_cast<char *>(&totals), sizeof(totals));
+
+  std::vector<double> flows, updateTimes;
+  std::vector<unsigned> versions, stamps;
+  std::vector<int> projected;
+  std::vector<fillingEvent> events;
+  bool valid = in && readValues(in, flows, totalElements) &&
+               readValues(in, updateTimes, totalElements) &&
+               readValues(in, versions, totalElements) &&
+               readValues(in, stamps, totalElements) &&
+               readValues(in, projected, totalElements) &&
+               readValues(in, events, data.size());
+  valid = valid && flows.size() == totalElements &&
+          updateTimes.size() == totalElements &&
+          versions.size() == totalElements && stamps.size() == totalElements;
+  for (int index : projected)
+    valid = valid && index >= 0 && static_cast<size_t>(index) < totalElements;
+  for (const fillingEvent &event : events)
+    valid = valid && event.index >= 0 &&
+            static_cast<size_t>(event.index) < totalElements;
+  if (!valid) return false;
+
+  frontFlows.swap(flows);
+  frontUpdateTimes.swap(updateTimes);
+  eventVersions.swap(versions);
+  frontStamps.swap(stamps);
+  projectedElements.swap(projected);
+  fillingEvents = decltype(fillingEvents)();
+  for (const fillingEvent &event : events) fillingEvents.push(event);
+
+  totalFrontFlow = totals.totalFrontFlow;
+  solveCount = totals.solveCount;
+  fillingEventsSinceSolve = totals.fillingEventsSinceSolve;
+  filledFlowSinceSolve = totals.filledFlowSinceSolve;
+  return true;
+}
+
+void unsteadyStateSimulation::initialiseFillingEvents() {
+  // Batching relies on the filling events
+  eventDriven = userInput::get().eventDrivenUSS ||
+                userInput::get().maxFillingEventsPerSolve > 1;
+  if (!eventDriven) return;
+
+  int totalElements = network->totalPores + network->totalNodes;
+  frontFlows.assign(totalElements, 0);
+  frontUpdateTimes.assign(totalElements, 0);
+  eventVersions.assign(totalElements, 0);
+  frontStamps.assign(totalElements, 0);
+  projectedElements.clear();
+  fillingEvents = decltype(fillingEvents)();
+  totalFrontFlow = 0;
+  solveCount = 0;
+
+  fillingEventsBatch = std::max(1, userInput::get().maxFillingEventsPerSolve);
+  fillingEventsSinceSolve = 0;
+  filledFlowSinceSolve = 0;
+}
+
+void unsteadyStateSimulation::updateFillingEvents() {
+  // MEASURE_FUNCTION(); //Profiling
+
+  ++solveCount;
+  std::vector<int> projected;
+  double flowChange(0);
+
+  // Only elements whose flow changed get a new projected filling time
+  auto project = [this, &projected, &flowChange](element *e) {
+    int index = getFrontIndex(e);
+    frontStamps[index] = solveCount;
+
+    double flow = e->getActive() && std::abs(e->getFlow()) > 1e-50
+                      ? std::abs(e->getFlow())
+                      : 0;
+    if (flow != 0) projected.push_back(index);
+    if (std::abs(flow - frontFlows[index]) <= 1e-10 * flow &&
+        (flow != 0 || frontFlows[index] == 0))
+      return;
+
+    flowChange += std::abs(flow - frontFlows[index]);
+    frontFlows[index] = flow;
+    frontUpdateTimes[index] = timeSoFar;
+    eventVersions[index]++;
+    if (flow != 0)
+      fillingEvents.push(
+          {timeSoFar + e->getVolume() * e->getOilFraction() / flow, index,
+           eventVersions[index]});
+  };
+
+  for (pore *p : poresToCheck) project(p);
+  for (node *n : nodesToCheck) project(n);
+
+  // Elements that left the front stop being filled
+  for (int index : projectedElements)
+    if (frontStamps[index] != solveCount) {
+      flowChange += frontFlows[index];
+      frontFlows[index] = 0;
+      eventVersions[index]++;
+    }
+
+  projectedElements.swap(projected);
+
+  totalFrontFlow = 0;
+  for (int index : projectedElements) totalFrontFlow += frontFlows[index];
+
+  // Drop superseded events once they dominate the heap
+  if (fillingEvents.size() > 4 * projectedElements.size() + 1024) {
+    decltype(fillingEvents) validEvents;
+    while (!fillingEvents.empty()) {
+      const fillingEvent &event = fillingEvents.top();
+      if (event.version == eventVersions[event.index])
+        validEvents.push(event);
+      fillingEvents.pop();
+    }
+    fillingEvents.swap(validEvents);
+  }
+
+  // Error control against one solve per event: the batch size is halved when
+  // the flows moved more than the tolerance since the previous solve, and
+  // doubled again (up to the user limit) when they barely moved
+  int maxBatch = std::max(1, userInput::get().maxFillingEventsPerSolve);
+  double relativeFlowChange = flowChange / userInput::get().flowRate;
+  double tolerance = userInput::get().flowChangeTolerance;
+  if (fillingEventsSinceSolve > 1 && relativeFlowChange > tolerance)
+    fillingEventsBatch = std::max(1, fillingEventsBatch / 2);
+  else if (relativeFlowChange < tolerance / 4)
+    fillingEventsBatch = std::min(maxBatch, 2 * fillingEventsBatch);
+
+  fillingEventsSinceSolve = 0;
+  filledFlowSinceSolve = 0;
+  if (maxBatch > 1) updatePressureCalculation = false;
+}
+
+void unsteadyStateSimulation::updateFrontFractions() {
+  for (int index : projectedElements) {
+    element *e = getFrontElement(index);
+    double incrementalWater =
+        frontFlows[index] * (timeSoFar - frontUpdateTimes[index]);
+    if (incrementalWater == 0) {
+      frontUpdateTimes[index] = timeSoFar;
+      continue;
+    }
+
+    double previousFraction = e->getWaterFraction();
+    double waterFraction =
+        std::min(1.0, previousFraction + incrementalWater / e->getVolume());
+    e->setWaterFraction(waterFraction);
+    e->setOilFraction(1 - e->getWaterFraction());
+
+    // The update time only advances by the water the stored fraction took,
+    // the rest is added with the next update
+    if (e->getWaterFraction() == waterFraction)
+      frontUpdateTimes[index] = timeSoFar;
+    else
+      frontUpdateTimes[index] +=
+          (e->getWaterFraction() - previousFraction) * e->getVolume() /
+          frontFlows[index];
+  }
+}
+
+double unsteadyStateSimulation::getNextFillingTime() {
+  while (!fillingEvents.empty() &&
+         fillingEvents.top().version !=
+             eventVersions[fillingEvents.top().index])
+    fillingEvents.pop();
+
+  return fillingEvents.empty() ? 1e50 : fillingEvents.top().time;
+}
+
+void unsteadyStateSimulation::processFillingEvents() {
+  // MEASURE_FUNCTION(); //Profiling
+
+  currentSw += totalFrontFlow * timeStep / network->totalNetworkVolume;
+
+  double newTime = timeSoFar + timeStep;
+  while (getNextFillingTime() < 1e50) {
+    fillingEvent event = fillingEvents.top();
+    element *e = getFrontElement(event.index);
+
+    // same filling tolerance as the fraction update
+    double remainingWater = frontFlows[event.index] * (event.time - newTime);
+    if (remainingWater > fillTolerance * e->getVolume()) break;
+
+    fillingEvents.pop();
+
+    phase previous = e->getPhaseFlag();
+    e->setPhaseFlag(phase::water);
+    e->setWaterFraction(1);
+    e->setOilFraction(0);
+    if (e->getType() == capillaryType::throat)
+      pnmOperation::get(network).updateOilNeighboors(e, previous);
+
+    totalFrontFlow -= frontFlows[event.index];
+    filledFlowSinceSolve += frontFlows[event.index];
+    frontFlows[event.index] = 0;
+    frontUpdateTimes[event.index] = newTime;
+    eventVersions[event.index]++;
+    fillingEventsSinceSolve++;
+
+    // The flows are kept until the batch is full or the front has lost too
+    // much of the injected flow to filled elements
+    if (fillingEventsSinceSolve >= fillingEventsBatch ||
+        filledFlowSinceSolve >
+            userInput::get().flowChangeTolerance * userInput::get().flowRate)
+      updatePressureCalculation = true;
+  }
+
+  // Nothing left to fill with the current flows
+  if (fillingEventsSinceSolve > 0 && getNextFillingTime() >= 1e50)
+    updatePressureCalculation = true;
+}
+
+int unsteadyStateSimulation::getFrontIndex(element *e) const {
+  return e->getType() == capillaryType::throat
+             ? e->getId() - 1
+             : network->totalPores + e->getId() - 1;
+}
 
-  outputCounter = injectedPVs;
+element *unsteadyStateSimulation::getFrontElement(int index) const {
+  if (index < network->totalPores) return network->getPore(index);
+  return network->getNode(index - network->totalPores);
 }
 
 void unsteadyStateSimulation::generateNetworkStateFiles() {
@@ -8,14 +8,26 @@
 #ifndef UNSTEADYSTATESIMULATION_H
 #define UNSTEADYSTATESIMULATION_H
 
+#include "misc/outputSchedule.h"
+#include "misc/resultsWriter.h"
+#include "network/elementset.h"
 #include "simulations/simulation.h"
 
-#include <unordered_set>
+#include <functional>
+#include <queue>
+#include <vector>
 
 namespace PNM {
 
-class pore;
-class node;
+class checkpoint;
+
+// Projected time at which the oil left in a front element is displaced
+struct fillingEvent {
+  double time;
+  int index;
+  unsigned version;
+  bool operator>(const fillingEvent &other) const { return time > other.time; }
+};
 
 class unsteadyStateSimulation : public simulation {
  public:
@@ -34,12 +46,15 @@ class unsteadyStateSimulation : public simulation {
 
  private:
   void initialiseOutputFiles();
+  void openOutputFiles(bool append);
   void initialiseCapillaries();
   void initialiseSimulationAttributes();
   void addWaterChannel();
   void setInitialTerminalFlags();
   void fetchTrappedCapillaries();
   void updateCapillaryPropreties();
+  void updatePoreCapillaryPropreties(pore *, std::vector<pore *> &,
+                                     std::vector<node *> &);
   void solvePressureField();
   void calculateTimeStep();
   void updateFluidFractions();
@@ -47,6 +62,20 @@ class unsteadyStateSimulation : public simulation {
   void updateOutputFiles();
   void generateNetworkStateFiles();
   void updateVariables();
+  void saveCheckpoint(checkpoint &);
+  bool restoreCheckpoint(checkpoint &);
+
+  // Event-driven mode: fill times are kept in a min-heap and fluid fractions
+  // are only brought up to date when the pressure field is recalculated
+  void initialiseFillingEvents();
+  void updateFillingEvents();
+  void updateFrontFractions();
+  double getNextFillingTime();
+  void processFillingEvents();
+  std::string saveFillingEvents() const;
+  bool restoreFillingEvents(const std::string &);
+  int getFrontIndex(element *) const;
+  element *getFrontElement(int) const;
 
   double simulationTime;
   double timeSoFar;
@@ -55,14 +84,37 @@ class unsteadyStateSimulation : public simulation {
   double currentSw;
   double capillaryNumber;
   double flowVelocity;
-  double outputCounter;
+  outputSchedule curvesOutput;
+  outputSchedule networkStatesOutput;
   int frameCount;
   bool updatePressureCalculation;
-  std::string satFilename;
-  std::string fractionalFilename;
-  std::string pressureFilename;
-  std::unordered_set<pore *> poresToCheck;
-  std::unordered_set<node *> nodesToCheck;
+  resultsWriter saturationsFile;
+  resultsWriter fractionalFlowsFile;
+  resultsWriter pressureFile;
+  elementSet<pore> poresToCheck;
+  elementSet<node> nodesToCheck;
+  std::vector<double> unstoredWater;  // water not in the stored fractions yet
+  int pressureFactorizations;         // pressure solves over the run
+  int pressureActiveSetPasses;        // throat closing passes over the run
+  int pressureIsolationFallbacks;     // solves refactorized on isolation
+  long long pressureIsolationVisits;  // nodes searched for isolation
+
+  bool eventDriven;
+  std::priority_queue<fillingEvent, std::vector<fillingEvent>,
+                      std::greater<fillingEvent>>
+      fillingEvents;
+  std::vector<double> frontFlows;        // flow used for each projection
+  std::vector<double> frontUpdateTimes;  // time of the last fraction update
+  std::vector<unsigned> eventVersions;   // invalidates superseded events
+  std::vector<unsigned> frontStamps;     // last solve an element was seen
+  std::vector<int> projectedElements;    // elements with a non-zero flow
+  double totalFrontFlow;
+  unsigned solveCount;
+
+  // Batching of filling events between pressure solves
+  int fillingEventsBatch;          // current maximum number of events
+  int fillingEventsSinceSolve;     // events filled with the current flows
+  double filledFlowSinceSolve;     // flow lost by the front since the solve
 };
 
 }  // namespace PNM